@@ -63,21 +63,23 @@ class Cluster implements ClusterInterface
             throw new InvalidArgumentException("Please use Cluster::connect() to connect to CNG.");
         }
         ExtensionNamespaceResolver::defineExtensionNamespace();
+        $exportedOptions = $options->export();
         // TODO(PCBC-1056): We should consider taking into account all the options that are passed to the backend for the connection hash
         $this->connectionHash = hash(
             "sha256",
             sprintf(
-                "--%s--%s--%b--%b--%b--%s--",
+                "--%s--%s--%b--%b--%b--%s--%s--",
                 $connectionString,
                 $options->authenticatorHash(),
                 $options->enableCoreTracing(),
                 $options->enableCoreMetrics(),
                 $options->bufferCoreSpans(),
+                $exportedOptions["coreSpansSamplingThreshold"] ?? "",
                 COUCHBASE_EXTENSION_NAMESPACE
             )
         );
         $function = COUCHBASE_EXTENSION_NAMESPACE . '\\createConnection';
-        $this->core = $function($this->connectionHash, $connectionString, $options->export());
+        $this->core = $function($this->connectionHash, $connectionString, $exportedOptions);
         $this->options = $options;
 
         $tracer = ClusterOptions::getTracer($options);
@@ -153,6 +155,9 @@ class Cluster implements ClusterInterface
      * In case `pcntl_fork()` returns negative value, and the application decides to continue, `notifyFork(ForkEvent::PARENT)`
      * must be invoked to resume the SDK.
      *
+     * When `couchbase.fork_handlers` INI setting is enabled, the extension invokes the same logic automatically
+     * using `pthread_atfork()`, and calling this method is not necessary. Explicit calls still take precedence.
+     *
      * @see https://www.php.net/manual/en/function.pcntl-fork.php
      * @see https://www.php.net/manual/en/function.proc-open.php
      *
@@ -168,6 +173,78 @@ class Cluster implements ClusterInterface
         return $function($event);
     }
 
+    /**
+     * Returns the number of log messages dropped since the start of the process, because the queue of the
+     * messages deferred for `php_log_err()` was full.
+     *
+     * The capacity of the queue is controlled by `couchbase.log_queue_size` INI setting (rounded up to the power
+     * of two, at most 65536), and `couchbase.log_queue_policy` selects whether the newest or the oldest messages
+     * are dropped.
+     *
+     * @return int
+     *
+     * @since 4.5.0
+     */
+    public static function droppedLogMessages(): int
+    {
+        ExtensionNamespaceResolver::defineExtensionNamespace();
+        $function = COUCHBASE_EXTENSION_NAMESPACE . '\\droppedLogMessages';
+        return $function();
+    }
+
+    /**
+     * Returns metrics of the operations merged from all processes, that write into the shared memory
+     * segment configured with `couchbase.metrics_shm_name` INI setting (e.g. all FPM workers of the
+     * pool). The entries have the same structure as the result of {@link Cluster::metricsSnapshot()}.
+     *
+     * @return array|null null if the shared memory segment is not configured
+     *
+     * @since 4.5.0
+     */
+    public static function sharedMetricsSnapshot(): ?array
+    {
+        ExtensionNamespaceResolver::defineExtensionNamespace();
+        $function = COUCHBASE_EXTENSION_NAMESPACE . '\\sharedMetricsSnapshot';
+        return $function();
+    }
+
+    /**
+     * Renders metrics of the operations merged from all processes, that write into the shared memory
+     * segment configured with `couchbase.metrics_shm_name` INI setting, in OpenMetrics text format.
+     *
+     * @return string|null null if the shared memory segment is not configured
+     *
+     * @since 4.5.0
+     */
+    public static function sharedMetricsOpenMetrics(): ?string
+    {
+        ExtensionNamespaceResolver::defineExtensionNamespace();
+        $function = COUCHBASE_EXTENSION_NAMESPACE . '\\sharedMetricsOpenMetrics';
+        return $function();
+    }
+
+    /**
+     * Turns the connection into a "fork template". The SDK opens the given buckets and waits until their
+     * configurations are loaded, and waits for them again before every `fork()` (announced with
+     * `notifyFork(ForkEvent::PREPARE)` or by the fork handlers). While the connection is running, the
+     * configurations are kept up to date as usual. The child processes inherit the topology and the opened
+     * buckets, so they do not need to bootstrap the connection again after `notifyFork(ForkEvent::CHILD)`.
+     *
+     * Typically used by the master process of the `pcntl_fork()`-based workers (e.g. queue consumers).
+     *
+     * @param string[] $bucketNames names of the buckets that the child processes will use
+     * @return void
+     *
+     * @throws CouchbaseException
+     * @see Cluster::notifyFork()
+     * @since 4.5.0
+     */
+    public function prepareForkTemplate(array $bucketNames = []): void
+    {
+        $function = COUCHBASE_EXTENSION_NAMESPACE . '\\prepareForkTemplate';
+        $function($this->core, $bucketNames);
+    }
+
     /**
      * Returns a new bucket object.
      *
@@ -445,6 +522,49 @@ class Cluster implements ClusterInterface
         return new Transactions($this->core, $config ?: $this->options->getTransactionsConfiguration());
     }
 
+    /**
+     * Returns latency histograms of the operations executed through this connection since it has been
+     * created (persistent connections accumulate the values across the requests). Every entry describes
+     * one combination of service, operation and bucket:
+     *
+     * * `service`, `operation`, `bucket` - the group of the operations
+     * * `count`, `errors` - the number of the operations, and how many of them failed
+     * * `inFlight` - the number of the operations currently waiting for the response
+     * * `timeouts`, `retries` - the number of the timed out operations, and the total number of retries
+     * * `sumUs`, `minUs`, `maxUs` - the total, minimal and maximal latency in microseconds
+     * * `percentilesUs` - the latency at the 50th, 90th, 99th, 99.9th and 100th percentiles
+     * * `bucketsUs` - pairs of the highest latency of the histogram bucket and the number of operations in it
+     *
+     * The values are measured by the extension around the network operation, so the application does not
+     * have to time each call in PHP.
+     *
+     * @return array
+     * @since 4.5.0
+     */
+    public function metricsSnapshot(): array
+    {
+        $function = COUCHBASE_EXTENSION_NAMESPACE . '\\metricsSnapshot';
+        return $function($this->core);
+    }
+
+    /**
+     * Renders the metrics collected by the extension in OpenMetrics text format, ready to be returned
+     * from the scrape endpoint (e.g. FPM status page) with content type
+     * `application/openmetrics-text; version=1.0.0; charset=utf-8`.
+     *
+     * The exposition includes latency histograms, number of the operations in flight, errors, timeouts
+     * and retries for every group of the operations, number of the connections to the nodes by service
+     * and state, and the usage of the persistent connections pool of the process.
+     *
+     * @return string
+     * @since 4.5.0
+     */
+    public function metricsOpenMetrics(): string
+    {
+        $function = COUCHBASE_EXTENSION_NAMESPACE . '\\metricsOpenMetrics';
+        return $function($this->core);
+    }
+
     /**
      * @param string $bucketName
      *
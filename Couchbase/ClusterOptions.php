@@ -43,6 +43,7 @@ class ClusterOptions
     private ?int $configPollIntervalMilliseconds = null;
     private ?int $idleHttpConnectionTimeoutMilliseconds = null;
     private ?int $tcpKeepAliveIntervalMilliseconds = null;
+    private ?int $coreSpansSamplingThresholdMilliseconds = null;
 
     private ?bool $enableClustermapNotification = null;
     private ?bool $enableCompression = null;
@@ -543,6 +544,25 @@ class ClusterOptions
         return $this;
     }
 
+    /**
+     * Enables tail-based sampling of the spans recorded by the SDK core.
+     *
+     * The spans are still recorded for every operation, but they are passed to the tracer (or
+     * to the exporter configured with couchbase.otlp_endpoint) only when the operation has failed
+     * or took at least the given time. Spans of the fast successful operations are dropped inside
+     * the extension without creating PHP objects for them.
+     *
+     * @param int $milliseconds
+     *
+     * @return ClusterOptions
+     * @since 4.5.0
+     */
+    public function coreSpansSamplingThreshold(int $milliseconds): ClusterOptions
+    {
+        $this->coreSpansSamplingThresholdMilliseconds = $milliseconds;
+        return $this;
+    }
+
     /**
      * Select the server group to use for replica APIs.
      *
@@ -684,6 +704,7 @@ class ClusterOptions
             'enableCoreTracing' => $this->enableCoreTracing(),
             'enableCoreMetrics' => $this->enableCoreMetrics(),
             'bufferCoreSpans' => $this->bufferCoreSpans(),
+            'coreSpansSamplingThreshold' => $this->coreSpansSamplingThresholdMilliseconds,
         ];
     }
 
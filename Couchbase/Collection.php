@@ -125,13 +125,13 @@ class Collection implements CollectionInterface
      * @param string $id the key of the document to fetch
      * @param GetOptions|null $options the options to use for the operation
      *
-     * @return GetResult
+     * @return GetResult|null null if the document does not exist and GetOptions::returnNullOnMissing() is set
      * @throws DocumentNotFoundException
      * @throws TimeoutException
      * @throws CouchbaseException
      * @since 4.0.0
      */
-    public function get(string $id, ?GetOptions $options = null): GetResult
+    public function get(string $id, ?GetOptions $options = null): ?GetResult
     {
         return $this->observability->recordOperation(
             ObservabilityConstants::OP_GET,
@@ -147,6 +147,9 @@ class Collection implements CollectionInterface
                     GetOptions::export($options),
                     $obsHandler->getCoreSpansArray()
                 );
+                if (is_null($response)) {
+                    return null;
+                }
                 return new GetResult($response, GetOptions::getTranscoder($options));
             }
         );
@@ -570,13 +573,13 @@ class Collection implements CollectionInterface
      * @param array<LookupInSpec> $specs the array of selectors to query against the document
      * @param LookupInOptions|null $options the options to use for the operation
      *
-     * @return LookupInResult
+     * @return LookupInResult|null null if the document does not exist and LookupInOptions::returnNullOnMissing() is set
      * @throws DocumentNotFoundException
      * @throws TimeoutException
      * @throws CouchbaseException
      * @since 4.0.0
      */
-    public function lookupIn(string $id, array $specs, ?LookupInOptions $options = null): LookupInResult
+    public function lookupIn(string $id, array $specs, ?LookupInOptions $options = null): ?LookupInResult
     {
         return $this->observability->recordOperation(
             ObservabilityConstants::OP_LOOKUP_IN,
@@ -602,6 +605,9 @@ class Collection implements CollectionInterface
                     LookupInOptions::export($options),
                     $obsHandler->getCoreSpansArray()
                 );
+                if (is_null($response)) {
+                    return null;
+                }
                 return new LookupInResult($response, LookupInOptions::getTranscoder($options));
             }
         );
@@ -757,7 +763,8 @@ class Collection implements CollectionInterface
      * @param array $ids array of IDs, organized like this ["key1", "key2", ...]
      * @param GetOptions|null $options the options to use for the operation
      *
-     * @return array<GetResult> array of GetResult, one for each of the entries
+     * @return array<GetResult|null> array of GetResult, one for each of the entries (null for the missing
+     *   documents, if GetOptions::returnNullOnMissing() is set)
      * @since 4.0.0
      */
     public function getMulti(array $ids, ?GetOptions $options = null): array
@@ -776,7 +783,10 @@ class Collection implements CollectionInterface
                     GetOptions::export($options)
                 );
                 return array_map(
-                    function (array $response) use ($options) {
+                    function (?array $response) use ($options) {
+                        if (is_null($response)) {
+                            return null;
+                        }
                         return new GetResult($response, GetOptions::getTranscoder($options));
                     },
                     $responses
@@ -30,7 +30,7 @@ interface CollectionInterface
 
     public function name(): string;
 
-    public function get(string $id, ?GetOptions $options = null): GetResult;
+    public function get(string $id, ?GetOptions $options = null): ?GetResult;
 
     public function exists(string $id, ?ExistsOptions $options = null): ExistsResult;
 
@@ -54,7 +54,7 @@ interface CollectionInterface
 
     public function touch(string $id, $expiry, ?TouchOptions $options = null): MutationResult;
 
-    public function lookupIn(string $id, array $specs, ?LookupInOptions $options = null): LookupInResult;
+    public function lookupIn(string $id, array $specs, ?LookupInOptions $options = null): ?LookupInResult;
 
     public function mutateIn(string $id, array $specs, ?MutateInOptions $options = null): MutateInResult;
 
@@ -26,6 +26,7 @@ class GetOptions
     private ?int $timeoutMilliseconds = null;
     private bool $withExpiry = false;
     private ?array $projections = null;
+    private bool $returnNullOnMissing = false;
     private ?RequestSpan $parentSpan = null;
 
     /**
@@ -98,6 +99,25 @@ class GetOptions
         return $this;
     }
 
+    /**
+     * Sets whether to return null instead of throwing DocumentNotFoundException when the
+     * document does not exist.
+     *
+     * For getMulti() the missing documents are represented by null entries of the result.
+     * This is cheaper than constructing and catching exceptions for workloads with high
+     * miss rates (e.g. read-through caches).
+     *
+     * @param bool $returnNull whether to return null for missing documents
+     *
+     * @return GetOptions
+     * @since 4.5.0
+     */
+    public function returnNullOnMissing(bool $returnNull): GetOptions
+    {
+        $this->returnNullOnMissing = $returnNull;
+        return $this;
+    }
+
     /**
      * Associate custom transcoder with the request.
      *
@@ -167,6 +187,7 @@ class GetOptions
             'timeoutMilliseconds' => $options->timeoutMilliseconds,
             'withExpiry' => $options->withExpiry,
             'projections' => $options->projections,
+            'returnNullOnMissing' => $options->returnNullOnMissing,
         ];
     }
 }
@@ -25,6 +25,7 @@ class LookupInOptions
     private Transcoder $transcoder;
     private ?int $timeoutMilliseconds = null;
     private ?bool $withExpiry = null;
+    private bool $returnNullOnMissing = false;
     private ?RequestSpan $parentSpan = null;
 
     /**
@@ -92,6 +93,21 @@ class LookupInOptions
         return $this->withExpiry;
     }
 
+    /**
+     * Sets whether to return null instead of throwing DocumentNotFoundException when the
+     * document does not exist.
+     *
+     * @param bool $returnNull whether to return null for missing documents
+     *
+     * @return LookupInOptions
+     * @since 4.5.0
+     */
+    public function returnNullOnMissing(bool $returnNull): LookupInOptions
+    {
+        $this->returnNullOnMissing = $returnNull;
+        return $this;
+    }
+
     /**
      * Associate custom transcoder with the request.
      *
@@ -159,6 +175,7 @@ class LookupInOptions
         }
         return [
             'timeoutMilliseconds' => $options->timeoutMilliseconds,
+            'returnNullOnMissing' => $options->returnNullOnMissing,
         ];
     }
 }
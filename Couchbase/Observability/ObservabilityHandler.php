@@ -23,6 +23,7 @@ namespace Couchbase\Observability;
 use Couchbase\AnalyticsOptions;
 use Couchbase\DurabilityLevel;
 use Couchbase\Exception\CouchbaseException;
+use Couchbase\LoggingMeter;
 use Couchbase\QueryOptions;
 use Couchbase\RequestSpan;
 use Couchbase\RequestTracer;
@@ -31,13 +32,27 @@ use Throwable;
 
 class ObservabilityHandler
 {
+    private const CORE_SPAN_NAME = 0;
+    private const CORE_SPAN_PARENT = 1;
+    private const CORE_SPAN_START = 2;
+    private const CORE_SPAN_END = 3;
+    private const CORE_SPAN_ATTRIBUTES = 4;
+
+    /**
+     * Operations timed by the extension, which records their durations into the meter of the core
+     * itself, so they are not recorded again through the LoggingMeter. The list is maintained by the
+     * extension, and fetched once per process.
+     */
+    private static ?array $coreMeteredOperations = null;
+
     private RequestTracer $tracer;
     private Meter $meter;
     private RequestSpan $opSpan;
+    private string $opName;
     private ?string $clusterName = null;
     private ?string $clusterUuid = null;
     private array $meterAttributes;
-    private float $startTime;
+    private int $startTimeNanoseconds;
     private array $coreSpans = [];
 
     public function __construct(
@@ -51,9 +66,10 @@ class ObservabilityHandler
         $this->populateClusterLabels($core);
         $this->tracer = $tracer;
         $this->meter = $meter;
+        $this->opName = $opName;
         $this->opSpan = $this->createSpan($opName, $parentSpan);
         $this->meterAttributes = $this->createMeterAttributes();
-        $this->startTime = microtime(true);
+        $this->startTimeNanoseconds = hrtime(true);
     }
 
     private function populateClusterLabels($core): void
@@ -193,8 +209,12 @@ class ObservabilityHandler
     {
         $this->opSpan->end();
 
-        // Calculate duration in microseconds
-        $durationUs = (int) round((microtime(true) - $this->startTime) * 1_000_000);
+        if ($this->meter instanceof LoggingMeter && isset(self::coreMeteredOperations()[$this->opName])) {
+            return;
+        }
+
+        // Monotonic clock is not affected by adjustments of the system time, and does not lose precision in floats
+        $durationUs = intdiv(hrtime(true) - $this->startTimeNanoseconds, 1_000);
 
         $valueRecorder = $this->meter->valueRecorder(
             ObservabilityConstants::METER_NAME_OPERATION_DURATION,
@@ -203,6 +223,15 @@ class ObservabilityHandler
         $valueRecorder->recordValue($durationUs);
     }
 
+    private static function coreMeteredOperations(): array
+    {
+        if (is_null(self::$coreMeteredOperations)) {
+            $function = COUCHBASE_EXTENSION_NAMESPACE . '\\coreMeteredOperations';
+            self::$coreMeteredOperations = $function();
+        }
+        return self::$coreMeteredOperations;
+    }
+
     private function createMeterAttributes(): array
     {
         $attrs = [
@@ -239,14 +268,38 @@ class ObservabilityHandler
         return $this->coreSpans;
     }
 
+    /**
+     * Creates spans from the flat list filled by the extension. Every core span is a list of
+     * [name, parent index, start timestamp, end timestamp, attributes], and it always follows its parent.
+     * Parent index -1 means that the span belongs directly to the operation span.
+     * The list is empty when the extension sampled the spans out, then the number of retries is unknown.
+     */
     public function createSpansFromCore(): void
     {
+        if (empty($this->coreSpans)) {
+            return;
+        }
         $dispatchSpanCount = 0;
-        foreach ($this->coreSpans as $coreSpan) {
-            if ($coreSpan['name'] == ObservabilityConstants::STEP_DISPATCH_TO_SERVER) {
-                $dispatchSpanCount++;
+        $spans = [];
+        foreach ($this->coreSpans as $index => $coreSpan) {
+            $parentIndex = $coreSpan[self::CORE_SPAN_PARENT];
+            if ($parentIndex < 0) {
+                $parentSpan = $this->opSpan;
+                if ($coreSpan[self::CORE_SPAN_NAME] == ObservabilityConstants::STEP_DISPATCH_TO_SERVER) {
+                    $dispatchSpanCount++;
+                }
+            } else {
+                $parentSpan = $spans[$parentIndex];
             }
-            $this->createSpanFromCore($coreSpan, $this->opSpan);
+            $span = $this->createSpan($coreSpan[self::CORE_SPAN_NAME], $parentSpan, $coreSpan[self::CORE_SPAN_START]);
+            foreach ($coreSpan[self::CORE_SPAN_ATTRIBUTES] as $key => $value) {
+                $span->addTag((string) $key, $value);
+            }
+            $spans[$index] = $span;
+        }
+        // children are ended before their parents
+        foreach (array_reverse($spans, true) as $index => $span) {
+            $span->end($this->coreSpans[$index][self::CORE_SPAN_END]);
         }
         if ($dispatchSpanCount > 0) {
             $this->opSpan->addTag(ObservabilityConstants::ATTR_RETRIES, $dispatchSpanCount - 1);
@@ -254,20 +307,4 @@ class ObservabilityHandler
             $this->opSpan->addTag(ObservabilityConstants::ATTR_RETRIES, 0);
         }
     }
-
-    private function createSpanFromCore(array $coreSpan, RequestSpan $parentSpan): void
-    {
-        $span = $this->createSpan($coreSpan['name'], $parentSpan, $coreSpan['start_timestamp']);
-        if (array_key_exists('attributes', $coreSpan)) {
-            foreach ($coreSpan['attributes'] as $key => $value) {
-                $span->addTag($key, $value);
-            }
-        }
-        if (array_key_exists('children', $coreSpan)) {
-            foreach ($coreSpan['children'] as $childCoreSpan) {
-                $this->createSpanFromCore($childCoreSpan, $span);
-            }
-        }
-        $span->end($coreSpan['end_timestamp']);
-    }
 }
@@ -149,7 +149,7 @@ class Collection implements CollectionInterface
         return KVResponseConverter::convertMutationResult($key, $res);
     }
 
-    public function get(string $key, ?GetOptions $options = null): GetResult
+    public function get(string $key, ?GetOptions $options = null): ?GetResult
     {
         $exportedOptions = GetOptions::export($options);
         $request = RequestFactory::makeRequest(
@@ -157,10 +157,17 @@ class Collection implements CollectionInterface
             [$key, $exportedOptions, KVRequestConverter::getLocation($this->bucketName, $this->scopeName, $this->name)]
         );
         $timeout = $this->client->timeoutHandler()->getTimeout(TimeoutHandler::KV, $exportedOptions);
-        $res = ProtostellarOperationRunner::runUnary(
-            SharedUtils::createProtostellarRequest($request, true, $timeout),
-            [$this->client->kv(), 'Get']
-        );
+        try {
+            $res = ProtostellarOperationRunner::runUnary(
+                SharedUtils::createProtostellarRequest($request, true, $timeout),
+                [$this->client->kv(), 'Get']
+            );
+        } catch (DocumentNotFoundException $e) {
+            if ($exportedOptions['returnNullOnMissing'] ?? false) {
+                return null;
+            }
+            throw $e;
+        }
         return KVResponseConverter::convertGetResult($key, $res, $options);
     }
 
@@ -250,7 +257,7 @@ class Collection implements CollectionInterface
         return KVResponseConverter::convertTouchResult($key, $res);
     }
 
-    public function lookupIn(string $key, array $specs, ?LookupInOptions $options = null): LookupInResult
+    public function lookupIn(string $key, array $specs, ?LookupInOptions $options = null): ?LookupInResult
     {
         $exportedOptions = LookupInOptions::export($options);
         [$request, $order] = RequestFactory::makeRequest(
@@ -258,10 +265,17 @@ class Collection implements CollectionInterface
             [$key, $specs, KVRequestConverter::getLocation($this->bucketName, $this->scopeName, $this->name), $options]
         );
         $timeout = $this->client->timeoutHandler()->getTimeout(TimeoutHandler::KV, $exportedOptions);
-        $res = ProtostellarOperationRunner::runUnary(
-            SharedUtils::createProtostellarRequest($request, true, $timeout),
-            [$this->client->kv(), 'LookupIn']
-        );
+        try {
+            $res = ProtostellarOperationRunner::runUnary(
+                SharedUtils::createProtostellarRequest($request, true, $timeout),
+                [$this->client->kv(), 'LookupIn']
+            );
+        } catch (DocumentNotFoundException $e) {
+            if ($exportedOptions['returnNullOnMissing'] ?? false) {
+                return null;
+            }
+            throw $e;
+        }
         return KVResponseConverter::convertLookupInResult($key, $res, SharedUtils::toArray($request->getSpecs()), $order, $options);
     }
 
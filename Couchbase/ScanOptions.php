@@ -31,6 +31,12 @@ class ScanOptions
     private ?int $batchByteLimit = null;
     private ?int $batchItemLimit = null;
     private ?int $concurrency = null;
+    private ?int $prefetchSize = null;
+    private ?int $partitionIndex = null;
+    private ?int $partitionCount = null;
+    private ?bool $resumable = null;
+    private ?array $resumeFrom = null;
+    private ?array $projections = null;
     private ?RequestSpan $parentSpan = null;
 
     /**
@@ -156,6 +162,102 @@ class ScanOptions
         return $this;
     }
 
+    /**
+     * Sets the maximum number of items that the SDK buffers in the background, while the application
+     * iterates over the results. The buffer is filled from all vBuckets that are scanned in parallel.
+     *
+     * @param int $prefetchSize
+     *
+     * @return ScanOptions
+     * @throws InvalidArgumentException
+     * @since 4.5.0
+     */
+    public function prefetchSize(int $prefetchSize): ScanOptions
+    {
+        if ($prefetchSize < 1) {
+            throw new InvalidArgumentException("Prefetch size must be positive");
+        }
+        $this->prefetchSize = $prefetchSize;
+        return $this;
+    }
+
+    /**
+     * Restricts the scan to a subset of the vBuckets, so that several processes can scan disjoint slices
+     * of the collection in parallel. The scan covers every vBucket, which number modulo `$count` equals
+     * to `$index`, therefore running the same scan with all indexes from `0` to `$count - 1` returns
+     * every document exactly once.
+     *
+     * @param int $index index of the slice, starting from zero
+     * @param int $count total number of the slices
+     *
+     * @return ScanOptions
+     * @throws InvalidArgumentException
+     * @since 4.5.0
+     */
+    public function partition(int $index, int $count): ScanOptions
+    {
+        if ($count < 1) {
+            throw new InvalidArgumentException("Partition count must be positive");
+        }
+        if ($index < 0 || $index >= $count) {
+            throw new InvalidArgumentException("Partition index must be in range [0, count)");
+        }
+        $this->partitionIndex = $index;
+        $this->partitionCount = $count;
+        return $this;
+    }
+
+    /**
+     * Sets whether to include only the given paths of the JSON documents in the scan results.
+     *
+     * The projection is applied by the extension as the items arrive from the server, so only the compact
+     * projected documents are buffered and passed to PHP. Documents that are not JSON are returned
+     * unchanged.
+     *
+     * @param array $projections the array of field paths (array of strings)
+     *
+     * @return ScanOptions
+     * @since 4.5.0
+     */
+    public function project(array $projections): ScanOptions
+    {
+        $this->projections = $projections;
+        return $this;
+    }
+
+    /**
+     * Makes the scan resumable, so that {@link ScanResults::checkpoint()} can be used to save its progress.
+     *
+     * Sampling scans cannot be resumable.
+     *
+     * @param bool $resumable whether the scan maintains the checkpoint
+     *
+     * @return ScanOptions
+     * @since 4.5.0
+     */
+    public function resumable(bool $resumable): ScanOptions
+    {
+        $this->resumable = $resumable;
+        return $this;
+    }
+
+    /**
+     * Continues the scan from the checkpoint returned by {@link ScanResults::checkpoint()}, skipping the
+     * documents that have been already processed. The scan must use the same scan type and options, and the
+     * checkpoint determines the vBuckets to scan, so partition options are ignored. The resumed scan is
+     * resumable as well.
+     *
+     * @param array $checkpoint the checkpoint of the interrupted scan
+     *
+     * @return ScanOptions
+     * @since 4.5.0
+     */
+    public function resumeFrom(array $checkpoint): ScanOptions
+    {
+        $this->resumeFrom = $checkpoint;
+        return $this;
+    }
+
     /**
      * Sets the parent span.
      *
@@ -214,6 +316,12 @@ class ScanOptions
             'batchByteLimit' => $options->batchByteLimit,
             'batchItemLimit' => $options->batchItemLimit,
             'concurrency' => $options->concurrency,
+            'prefetchSize' => $options->prefetchSize,
+            'partitionIndex' => $options->partitionIndex,
+            'partitionCount' => $options->partitionCount,
+            'resumable' => $options->resumable,
+            'resumeFrom' => $options->resumeFrom,
+            'projections' => $options->projections,
         ];
     }
 }
@@ -20,6 +20,7 @@ declare(strict_types=1);
 
 namespace Couchbase;
 
+use Couchbase\Exception\CouchbaseException;
 use IteratorAggregate;
 use Traversable;
 
@@ -28,12 +29,22 @@ use Traversable;
  */
 class ScanResults implements IteratorAggregate
 {
+    /**
+     * Maximum number of items fetched from the extension at once
+     */
+    private const BATCH_SIZE = 128;
+
     /**
      * @var resource
      */
     private $coreScanResult;
     private Transcoder $transcoder;
 
+    /**
+     * Number of items of the current batch returned by the iterator
+     */
+    private int $processedItems = 0;
+
     /**
      * @param $core
      * @param string $bucketName
@@ -71,12 +82,33 @@ class ScanResults implements IteratorAggregate
     public function getIterator(): Traversable
     {
         return (function () {
-            $function = COUCHBASE_EXTENSION_NAMESPACE . '\\documentScanNextItem';
-            $res = $function($this->coreScanResult);
-            while (!is_null($res)) {
-                yield new ScanResult($res, $this->transcoder);
-                $res = $function($this->coreScanResult);
+            $function = COUCHBASE_EXTENSION_NAMESPACE . '\\documentScanNextBatch';
+            $batch = $function($this->coreScanResult, self::BATCH_SIZE);
+            while (!is_null($batch)) {
+                foreach ($batch as $res) {
+                    ++$this->processedItems;
+                    yield new ScanResult($res, $this->transcoder);
+                }
+                $this->processedItems = 0;
+                $batch = $function($this->coreScanResult, self::BATCH_SIZE);
             }
         })();
     }
+
+    /**
+     * Returns the checkpoint of the scan that covers every document returned by the iterator so far. The
+     * checkpoint is a plain array that can be serialized, and passed to {@link ScanOptions::resumeFrom()}
+     * to continue the interrupted scan. The scan must be created with {@link ScanOptions::resumable()},
+     * {@link ScanOptions::resumeFrom()} or {@link ScanOptions::partition()}.
+     *
+     * @return array
+     * @throws CouchbaseException
+     *
+     * @since 4.5.0
+     */
+    public function checkpoint(): array
+    {
+        $function = COUCHBASE_EXTENSION_NAMESPACE . '\\documentScanCheckpoint';
+        return $function($this->coreScanResult, $this->processedItems);
+    }
 }
@@ -249,6 +249,44 @@ class TransactionAttemptContext
         );
     }
 
+    /**
+     * Stages a group of mutations concurrently, and returns when all of them are staged.
+     *
+     * The mutations must be independent of each other, for example they cannot touch the same document.
+     * The time to stage the batch is defined by the slowest mutation, instead of the sum of the round trips
+     * required by the sequence of {@link insert()}, {@link replace()} and {@link remove()} calls.
+     *
+     * @param array<TransactionStageSpec> $specs The specs describing each mutation
+     *
+     * @return array<TransactionGetResult|null> results in the order of the specs, null for removals
+     * @since 4.5.0
+     */
+    public function stageMulti(array $specs): array
+    {
+        $specs = array_values($specs);
+        $function = COUCHBASE_EXTENSION_NAMESPACE . '\\transactionStageMulti';
+        $response = $function(
+            $this->transaction,
+            array_map(
+                function (TransactionStageSpec $spec) {
+                    return TransactionStageSpec::export($spec);
+                },
+                $specs
+            )
+        );
+
+        return array_map(
+            function ($entry, TransactionStageSpec $spec) {
+                if ($entry == null) {
+                    return null;
+                }
+                return new TransactionGetResult($entry, TransactionStageSpec::getTranscoder($spec));
+            },
+            $response,
+            $specs
+        );
+    }
+
     /**
      * Executes a query in the context of this transaction.
      *
@@ -265,4 +303,26 @@ class TransactionAttemptContext
 
         return new QueryResult($result, TransactionQueryOptions::getTranscoder($options));
     }
+
+    /**
+     * Executes a query in the context of this transaction, and returns the rows as an iterator, which decodes
+     * them in batches instead of materializing the whole result set at once.
+     *
+     * Note that only decoding of the rows is batched: the query response is still received as a whole before
+     * the first row is returned, and the extension holds the raw rows until they are iterated, so the memory
+     * used by the result set is not bounded.
+     *
+     * @param string $statement
+     * @param TransactionQueryOptions|null $options
+     *
+     * @return TransactionQueryResults
+     * @since 4.5.0
+     */
+    public function queryRows(string $statement, ?TransactionQueryOptions $options = null): TransactionQueryResults
+    {
+        $function = COUCHBASE_EXTENSION_NAMESPACE . '\\transactionQueryRows';
+        $result = $function($this->transaction, $statement, TransactionQueryOptions::export($options));
+
+        return new TransactionQueryResults($result, TransactionQueryOptions::getTranscoder($options));
+    }
 }
@@ -0,0 +1,94 @@
+<?php
+
+/**
+ * Copyright 2014-Present Couchbase, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+declare(strict_types=1);
+
+namespace Couchbase;
+
+use IteratorAggregate;
+use Traversable;
+
+/**
+ * TransactionQueryResults iterates over the rows of the query executed in the context of the transaction.
+ * Unlike {@link QueryResult}, the rows are decoded in batches while iterating. The raw rows of the complete
+ * response are held by the extension until they are returned, so the memory is not bounded by the batch size.
+ */
+class TransactionQueryResults implements IteratorAggregate
+{
+    /**
+     * Maximum number of rows fetched from the extension at once
+     */
+    private const BATCH_SIZE = 128;
+
+    /**
+     * @var resource
+     */
+    private $coreQueryResult;
+    private Transcoder $transcoder;
+    private ?QueryMetaData $meta = null;
+
+    /**
+     * @param resource $coreQueryResult
+     * @param Transcoder $transcoder
+     *
+     * @internal
+     *
+     * @since 4.5.0
+     */
+    public function __construct($coreQueryResult, Transcoder $transcoder)
+    {
+        $this->coreQueryResult = $coreQueryResult;
+        $this->transcoder = $transcoder;
+    }
+
+    /**
+     * Returns metadata generated during query execution such as errors and metrics
+     *
+     * @return QueryMetaData
+     * @since 4.5.0
+     */
+    public function metaData(): QueryMetaData
+    {
+        if ($this->meta == null) {
+            $function = COUCHBASE_EXTENSION_NAMESPACE . '\\transactionQueryMetaData';
+            $this->meta = new QueryMetaData($function($this->coreQueryResult)["meta"]);
+        }
+        return $this->meta;
+    }
+
+    /**
+     * Returns the iterator over the rows, which are fetched from the extension in batches. The rows can be
+     * traversed only once.
+     *
+     * @return Traversable
+     * @since 4.5.0
+     */
+    public function getIterator(): Traversable
+    {
+        return (function () {
+            $function = COUCHBASE_EXTENSION_NAMESPACE . '\\transactionQueryNextBatch';
+            $batch = $function($this->coreQueryResult, self::BATCH_SIZE);
+            while (!is_null($batch)) {
+                foreach ($batch as $row) {
+                    yield $this->transcoder->decode($row, 0);
+                }
+                $batch = $function($this->coreQueryResult, self::BATCH_SIZE);
+            }
+        })();
+    }
+}
@@ -0,0 +1,143 @@
+<?php
+
+/**
+ * Copyright 2014-Present Couchbase, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+declare(strict_types=1);
+
+namespace Couchbase;
+
+/**
+ * Describes single mutation staged by {@link TransactionAttemptContext::stageMulti()}.
+ */
+class TransactionStageSpec
+{
+    private string $type;
+    private ?Collection $collection = null;
+    private ?string $id = null;
+    private ?TransactionGetResult $document = null;
+    private $value = null;
+    private ?Transcoder $transcoder = null;
+
+    private function __construct(string $type)
+    {
+        $this->type = $type;
+    }
+
+    /**
+     * Inserts a new document to the collection, failing if the document already exists.
+     *
+     * @param Collection $collection The collection the document lives in.
+     * @param string $id The document key to insert.
+     * @param mixed $value the document content to insert
+     * @param TransactionInsertOptions|null $options The options to use for the operation
+     *
+     * @return TransactionStageSpec
+     * @since 4.5.0
+     */
+    public static function insert(Collection $collection, string $id, $value, TransactionInsertOptions $options = null): TransactionStageSpec
+    {
+        $spec = new TransactionStageSpec('insert');
+        $spec->collection = $collection;
+        $spec->id = $id;
+        $spec->value = TransactionInsertOptions::encodeDocument($options, $value);
+        $spec->transcoder = TransactionInsertOptions::getTranscoder($options);
+        return $spec;
+    }
+
+    /**
+     * Replaces a document in a collection
+     *
+     * @param TransactionGetResult $document the document to replace
+     * @param mixed $value the document content to replace
+     * @param TransactionReplaceOptions|null $options The options to use for the operation
+     *
+     * @return TransactionStageSpec
+     * @since 4.5.0
+     */
+    public static function replace(TransactionGetResult $document, $value, TransactionReplaceOptions $options = null): TransactionStageSpec
+    {
+        $spec = new TransactionStageSpec('replace');
+        $spec->document = $document;
+        $spec->value = TransactionReplaceOptions::encodeDocument($options, $value);
+        $spec->transcoder = TransactionReplaceOptions::getTranscoder($options);
+        return $spec;
+    }
+
+    /**
+     * Removes a document from a collection.
+     *
+     * @param TransactionGetResult $document the document to remove
+     *
+     * @return TransactionStageSpec
+     * @since 4.5.0
+     */
+    public static function remove(TransactionGetResult $document): TransactionStageSpec
+    {
+        $spec = new TransactionStageSpec('remove');
+        $spec->document = $document;
+        return $spec;
+    }
+
+    /**
+     * @internal
+     *
+     * @param TransactionStageSpec $spec
+     *
+     * @return Transcoder|null
+     * @since 4.5.0
+     */
+    public static function getTranscoder(TransactionStageSpec $spec): ?Transcoder
+    {
+        return $spec->transcoder;
+    }
+
+    /**
+     * @internal
+     *
+     * @param TransactionStageSpec $spec
+     *
+     * @return array
+     * @since 4.5.0
+     */
+    public static function export(TransactionStageSpec $spec): array
+    {
+        switch ($spec->type) {
+            case 'insert':
+                return [
+                    'type' => $spec->type,
+                    'bucketName' => $spec->collection->bucketName(),
+                    'scopeName' => $spec->collection->scopeName(),
+                    'collectionName' => $spec->collection->name(),
+                    'id' => $spec->id,
+                    'value' => $spec->value[0],
+                    'flags' => $spec->value[1],
+                ];
+            case 'replace':
+                return [
+                    'type' => $spec->type,
+                    'document' => $spec->document->export(),
+                    'value' => $spec->value[0],
+                    'flags' => $spec->value[1],
+                ];
+            default:
+                return [
+                    'type' => $spec->type,
+                    'document' => $spec->document->export(),
+                ];
+        }
+    }
+}
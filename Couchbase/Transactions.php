@@ -56,28 +56,27 @@ class Transactions
      */
     public function run(callable $logic, ?TransactionOptions $options = null): TransactionResult
     {
-        $transaction = new TransactionAttemptContextDetails($this->transactions, $options);
-
-        while (true) {
-            $transaction->newAttempt();
+        $logicException = null;
+        $attempt = function ($transaction) use ($logic, &$logicException) {
             try {
-                $logic($transaction->transactionAttemptContext());
+                $logic(new TransactionAttemptContext($transaction));
             } catch (Exception $exception) {
-                $transaction->rollback();
-                throw new TransactionFailedException("Exception caught during execution of transaction logic. " . $exception->getMessage(), 0, $exception);
+                $logicException = $exception;
+                throw $exception;
             }
+        };
 
-            try {
-                $result = $transaction->commit(); // this is actually finalize internally
-                if ($result == null) {
-                    // no result and no error, try again
-                    continue;
-                }
-
-                return $result;
-            } catch (Exception $exception) {
-                // commit failed, retry...
+        // the extension runs attempts, commits and retries, and calls the logic once per attempt
+        $function = COUCHBASE_EXTENSION_NAMESPACE . '\\transactionRun';
+        try {
+            $response = $function($this->transactions, $attempt, TransactionOptions::export($options));
+        } catch (Exception $exception) {
+            if ($exception === $logicException) {
+                throw new TransactionFailedException("Exception caught during execution of transaction logic. " . $exception->getMessage(), 0, $exception);
             }
+            throw $exception;
         }
+
+        return new TransactionResult($response);
     }
 }
@@ -17,9 +17,12 @@
 #include "wrapper/common.hxx"
 #include "wrapper/core_span_resource.hxx"
 #include "wrapper/logger.hxx"
+#include "wrapper/otlp_exporter.hxx"
 #include "wrapper/persistent_connections_cache.hxx"
 #include "wrapper/scan_result_resource.hxx"
+#include "wrapper/shared_metrics.hxx"
 #include "wrapper/transaction_context_resource.hxx"
+#include "wrapper/transaction_query_result_resource.hxx"
 #include "wrapper/transactions_resource.hxx"
 #include "wrapper/version.hxx"
 
@@ -47,6 +50,11 @@ ZEND_RSRC_DTOR_FUNC(couchbase_destroy_transaction_context)
   couchbase::php::destroy_transaction_context_resource(res);
 }
 
+ZEND_RSRC_DTOR_FUNC(couchbase_destroy_transaction_query_result)
+{
+  couchbase::php::destroy_transaction_query_result_resource(res);
+}
+
 ZEND_RSRC_DTOR_FUNC(couchbase_destroy_core_scan_result)
 {
   couchbase::php::destroy_scan_result_resource(res);
@@ -86,6 +94,7 @@ PHP_METHOD(CouchbaseException, getContext)
     return;
   }
 
+  couchbase::php::materialize_exception_context(Z_OBJ_P(getThis()));
   zval *prop, rv;
   prop =
     couchbase_read_property(couchbase::php::couchbase_exception(), getThis(), "context", 0, &rv);
@@ -134,6 +143,8 @@ PHP_RINIT_FUNCTION(couchbase)
 {
   if (!COUCHBASE_G(initialized)) {
     couchbase::php::initialize_logger();
+    couchbase::php::initialize_shared_metrics();
+    couchbase::php::initialize_otlp_exporter();
     COUCHBASE_G(initialized) = 1;
   }
   return SUCCESS;
@@ -149,12 +160,27 @@ static const zend_function_entry exception_functions[] = {
 PHP_INI_BEGIN()
 STD_PHP_INI_ENTRY("couchbase.max_persistent", "-1", PHP_INI_SYSTEM, OnUpdateLong, max_persistent, zend_couchbase_globals, couchbase_globals)
 STD_PHP_INI_ENTRY("couchbase.persistent_timeout", "-1", PHP_INI_SYSTEM, OnUpdateLong, persistent_timeout, zend_couchbase_globals, couchbase_globals)
+/* prepare and resume the library around fork() automatically */
+STD_PHP_INI_ENTRY("couchbase.fork_handlers", "0", PHP_INI_SYSTEM, OnUpdateBool, fork_handlers, zend_couchbase_globals, couchbase_globals)
 STD_PHP_INI_ENTRY("couchbase.log_level", "", PHP_INI_ALL, OnUpdateString, log_level, zend_couchbase_globals, couchbase_globals)
 /* use php_error() for logging */
 STD_PHP_INI_ENTRY("couchbase.log_php_log_err", "1", PHP_INI_SYSTEM, OnUpdateBool, log_php_log_err, zend_couchbase_globals, couchbase_globals)
 STD_PHP_INI_ENTRY("couchbase.log_stderr", "0", PHP_INI_SYSTEM, OnUpdateBool, log_stderr, zend_couchbase_globals, couchbase_globals)
 /* write logs to given file (does not override couchbase.log_use_php_error) */
 STD_PHP_INI_ENTRY("couchbase.log_path", "", PHP_INI_SYSTEM, OnUpdateString, log_path, zend_couchbase_globals, couchbase_globals)
+/* maximum number of messages deferred for php_log_err(), and which messages to drop when it is full */
+STD_PHP_INI_ENTRY("couchbase.log_queue_size", "4096", PHP_INI_SYSTEM, OnUpdateLong, log_queue_size, zend_couchbase_globals, couchbase_globals)
+STD_PHP_INI_ENTRY("couchbase.log_queue_policy", "drop_newest", PHP_INI_SYSTEM, OnUpdateString, log_queue_policy, zend_couchbase_globals, couchbase_globals)
+/* levels per category of the messages, and maximum number of messages per second for every call site */
+STD_PHP_INI_ENTRY("couchbase.log_categories", "", PHP_INI_SYSTEM, OnUpdateString, log_categories, zend_couchbase_globals, couchbase_globals)
+STD_PHP_INI_ENTRY("couchbase.log_rate_limit", "0", PHP_INI_SYSTEM, OnUpdateLong, log_rate_limit, zend_couchbase_globals, couchbase_globals)
+/* name of the shared memory segment to aggregate metrics of all processes, and the number of processes it can hold */
+STD_PHP_INI_ENTRY("couchbase.metrics_shm_name", "", PHP_INI_SYSTEM, OnUpdateString, metrics_shm_name, zend_couchbase_globals, couchbase_globals)
+STD_PHP_INI_ENTRY("couchbase.metrics_shm_slots", "64", PHP_INI_SYSTEM, OnUpdateLong, metrics_shm_slots, zend_couchbase_globals, couchbase_globals)
+/* export spans of the operations in OTLP/JSON format from the background thread */
+STD_PHP_INI_ENTRY("couchbase.otlp_endpoint", "", PHP_INI_SYSTEM, OnUpdateString, otlp_endpoint, zend_couchbase_globals, couchbase_globals)
+STD_PHP_INI_ENTRY("couchbase.otlp_service_name", "php", PHP_INI_SYSTEM, OnUpdateString, otlp_service_name, zend_couchbase_globals, couchbase_globals)
+STD_PHP_INI_ENTRY("couchbase.otlp_queue_size", "2048", PHP_INI_SYSTEM, OnUpdateLong, otlp_queue_size, zend_couchbase_globals, couchbase_globals)
 PHP_INI_END()
 // clang-format on
 
@@ -177,12 +203,21 @@ PHP_MINIT_FUNCTION(couchbase)
                                       nullptr,
                                       "couchbase_transaction_context",
                                       module_number));
+  couchbase::php::set_transaction_query_result_destructor_id(
+    zend_register_list_destructors_ex(couchbase_destroy_transaction_query_result,
+                                      nullptr,
+                                      "couchbase_transaction_query_result",
+                                      module_number));
   couchbase::php::set_scan_result_destructor_id(zend_register_list_destructors_ex(
     couchbase_destroy_core_scan_result, nullptr, "couchbase_scan_result", module_number));
 
   couchbase::php::set_core_span_destructor_id(zend_register_list_destructors_ex(
     couchbase::php::destroy_core_span_resource, nullptr, "couchbase_core_span", module_number));
 
+  if (COUCHBASE_G(fork_handlers)) {
+    couchbase::php::enable_fork_handlers();
+  }
+
   return SUCCESS;
 }
 
@@ -210,6 +245,8 @@ namespace
 {
 PHP_MSHUTDOWN_FUNCTION(couchbase)
 {
+  couchbase::php::disable_fork_handlers();
+  couchbase::php::shutdown_otlp_exporter();
   couchbase::php::shutdown_logger();
 
   (void)type;
@@ -241,6 +278,38 @@ PHP_FUNCTION(notifyFork)
   RETURN_NULL();
 }
 
+PHP_FUNCTION(droppedLogMessages)
+{
+  if (zend_parse_parameters_none_throw() == FAILURE) {
+    RETURN_THROWS();
+  }
+  RETURN_LONG(static_cast<zend_long>(couchbase::php::dropped_log_messages()));
+}
+
+PHP_FUNCTION(sharedMetricsSnapshot)
+{
+  if (zend_parse_parameters_none_throw() == FAILURE) {
+    RETURN_THROWS();
+  }
+  auto snapshots = couchbase::php::shared_metrics_snapshots();
+  if (!snapshots) {
+    RETURN_NULL();
+  }
+  couchbase::php::operation_snapshots_to_zval(return_value, snapshots.value());
+}
+
+PHP_FUNCTION(sharedMetricsOpenMetrics)
+{
+  if (zend_parse_parameters_none_throw() == FAILURE) {
+    RETURN_THROWS();
+  }
+  auto text = couchbase::php::shared_metrics_open_metrics();
+  if (!text) {
+    RETURN_NULL();
+  }
+  RETURN_STRINGL(text->data(), text->size());
+}
+
 PHP_FUNCTION(loadExceptionAliases)
 {
   couchbase::php::initialize_exception_aliases();
@@ -329,6 +398,42 @@ PHP_FUNCTION(clusterLabels)
   handle->cluster_labels(return_value);
 }
 
+PHP_FUNCTION(metricsSnapshot)
+{
+  zval* connection = nullptr;
+
+  ZEND_PARSE_PARAMETERS_START(1, 1)
+  Z_PARAM_RESOURCE(connection)
+  ZEND_PARSE_PARAMETERS_END();
+
+  logger_flusher guard;
+
+  auto* handle = fetch_couchbase_connection_from_resource(connection);
+  if (handle == nullptr) {
+    RETURN_THROWS();
+  }
+
+  handle->metrics_snapshot(return_value);
+}
+
+PHP_FUNCTION(metricsOpenMetrics)
+{
+  zval* connection = nullptr;
+
+  ZEND_PARSE_PARAMETERS_START(1, 1)
+  Z_PARAM_RESOURCE(connection)
+  ZEND_PARSE_PARAMETERS_END();
+
+  logger_flusher guard;
+
+  auto* handle = fetch_couchbase_connection_from_resource(connection);
+  if (handle == nullptr) {
+    RETURN_THROWS();
+  }
+
+  handle->metrics_open_metrics(return_value);
+}
+
 PHP_FUNCTION(replicasConfiguredForBucket)
 {
   zval* connection = nullptr;
@@ -401,6 +506,29 @@ PHP_FUNCTION(closeBucket)
   }
 }
 
+PHP_FUNCTION(prepareForkTemplate)
+{
+  zval* connection = nullptr;
+  zval* bucket_names = nullptr;
+
+  ZEND_PARSE_PARAMETERS_START(2, 2)
+  Z_PARAM_RESOURCE(connection)
+  Z_PARAM_ARRAY(bucket_names)
+  ZEND_PARSE_PARAMETERS_END();
+
+  logger_flusher guard;
+
+  auto* handle = fetch_couchbase_connection_from_resource(connection);
+  if (handle == nullptr) {
+    RETURN_THROWS();
+  }
+
+  if (auto e = handle->prepare_fork_template(bucket_names); e.ec) {
+    couchbase_throw_exception(e);
+    RETURN_THROWS();
+  }
+}
+
 PHP_FUNCTION(authenticatorSet)
 {
   zval* connection = nullptr;
@@ -1231,6 +1359,50 @@ PHP_FUNCTION(documentScanNextItem)
   }
 }
 
+PHP_FUNCTION(documentScanNextBatch)
+{
+  zval* scan_result = nullptr;
+  zend_long limit = 0;
+
+  ZEND_PARSE_PARAMETERS_START(2, 2)
+  Z_PARAM_RESOURCE(scan_result)
+  Z_PARAM_LONG(limit)
+  ZEND_PARSE_PARAMETERS_END();
+
+  logger_flusher guard;
+
+  auto* scan_res = fetch_couchbase_scan_result_from_resource(scan_result);
+  if (scan_res == nullptr) {
+    RETURN_THROWS();
+  }
+  if (auto e = scan_res->next_batch(return_value, limit); e.ec) {
+    couchbase_throw_exception(e);
+    RETURN_THROWS();
+  }
+}
+
+PHP_FUNCTION(documentScanCheckpoint)
+{
+  zval* scan_result = nullptr;
+  zend_long processed_items = 0;
+
+  ZEND_PARSE_PARAMETERS_START(2, 2)
+  Z_PARAM_RESOURCE(scan_result)
+  Z_PARAM_LONG(processed_items)
+  ZEND_PARSE_PARAMETERS_END();
+
+  logger_flusher guard;
+
+  auto* scan_res = fetch_couchbase_scan_result_from_resource(scan_result);
+  if (scan_res == nullptr) {
+    RETURN_THROWS();
+  }
+  if (auto e = scan_res->checkpoint(return_value, processed_items); e.ec) {
+    couchbase_throw_exception(e);
+    RETURN_THROWS();
+  }
+}
+
 PHP_FUNCTION(documentGetMulti)
 {
   zval* connection = nullptr;
@@ -2739,6 +2911,55 @@ PHP_FUNCTION(createTransactionContext)
   RETURN_RES(resource);
 }
 
+PHP_FUNCTION(transactionRun)
+{
+  zval* transactions = nullptr;
+  zend_fcall_info logic = empty_fcall_info;
+  zend_fcall_info_cache logic_cache = empty_fcall_info_cache;
+  zval* configuration = nullptr;
+
+  ZEND_PARSE_PARAMETERS_START(2, 3)
+  Z_PARAM_RESOURCE(transactions)
+  Z_PARAM_FUNC(logic, logic_cache)
+  Z_PARAM_OPTIONAL
+  Z_PARAM_ARRAY_OR_NULL(configuration)
+  ZEND_PARSE_PARAMETERS_END();
+
+  logger_flusher guard;
+
+  auto* handle = fetch_couchbase_transactions_from_resource(transactions);
+  if (handle == nullptr) {
+    RETURN_THROWS();
+  }
+  auto [resource, e] = couchbase::php::create_transaction_context_resource(handle, configuration);
+  if (e.ec) {
+    couchbase_throw_exception(e);
+    RETURN_THROWS();
+  }
+  zval context;
+  ZVAL_RES(&context, resource);
+  auto* context_handle = static_cast<couchbase::php::transaction_context_resource*>(resource->ptr);
+
+  auto err = context_handle->run(return_value, [&logic, &logic_cache, &context]() {
+    zval retval;
+    ZVAL_UNDEF(&retval);
+    logic.retval = &retval;
+    logic.params = &context;
+    logic.param_count = 1;
+    auto rc = zend_call_function(&logic, &logic_cache);
+    zval_ptr_dtor(&retval);
+    return rc == SUCCESS && EG(exception) == nullptr;
+  });
+  zval_ptr_dtor(&context);
+  if (EG(exception) != nullptr) {
+    RETURN_THROWS();
+  }
+  if (err.ec) {
+    couchbase_throw_exception(err);
+    RETURN_THROWS();
+  }
+}
+
 PHP_FUNCTION(transactionNewAttempt)
 {
   zval* transaction = nullptr;
@@ -2991,6 +3212,28 @@ PHP_FUNCTION(transactionRemove)
   }
 }
 
+PHP_FUNCTION(transactionStageMulti)
+{
+  zval* transaction = nullptr;
+  zval* mutations = nullptr;
+
+  ZEND_PARSE_PARAMETERS_START(2, 2)
+  Z_PARAM_RESOURCE(transaction)
+  Z_PARAM_ARRAY(mutations)
+  ZEND_PARSE_PARAMETERS_END();
+
+  logger_flusher guard;
+
+  auto* context = fetch_couchbase_transaction_context_from_resource(transaction);
+  if (context == nullptr) {
+    RETURN_THROWS();
+  }
+  if (auto e = context->stage_multi(return_value, mutations); e.ec) {
+    couchbase_throw_exception(e);
+    RETURN_THROWS();
+  }
+}
+
 PHP_FUNCTION(transactionQuery)
 {
   zval* transaction = nullptr;
@@ -3016,6 +3259,82 @@ PHP_FUNCTION(transactionQuery)
   }
 }
 
+static inline couchbase::php::transaction_query_result_resource*
+fetch_couchbase_transaction_query_result_from_resource(zval* resource)
+{
+  return static_cast<couchbase::php::transaction_query_result_resource*>(
+    zend_fetch_resource(Z_RES_P(resource),
+                        "couchbase_transaction_query_result",
+                        couchbase::php::get_transaction_query_result_destructor_id()));
+}
+
+PHP_FUNCTION(transactionQueryRows)
+{
+  zval* transaction = nullptr;
+  zend_string* statement = nullptr;
+  zval* options = nullptr;
+
+  ZEND_PARSE_PARAMETERS_START(2, 3)
+  Z_PARAM_RESOURCE(transaction)
+  Z_PARAM_STR(statement)
+  Z_PARAM_OPTIONAL
+  Z_PARAM_ARRAY_OR_NULL(options)
+  ZEND_PARSE_PARAMETERS_END();
+
+  logger_flusher guard;
+
+  auto* context = fetch_couchbase_transaction_context_from_resource(transaction);
+  if (context == nullptr) {
+    RETURN_THROWS();
+  }
+  auto [resource, e] =
+    couchbase::php::create_transaction_query_result_resource(context, statement, options);
+  if (e.ec) {
+    couchbase_throw_exception(e);
+    RETURN_THROWS();
+  }
+  RETURN_RES(resource);
+}
+
+PHP_FUNCTION(transactionQueryNextBatch)
+{
+  zval* query_result = nullptr;
+  zend_long limit = 0;
+
+  ZEND_PARSE_PARAMETERS_START(2, 2)
+  Z_PARAM_RESOURCE(query_result)
+  Z_PARAM_LONG(limit)
+  ZEND_PARSE_PARAMETERS_END();
+
+  logger_flusher guard;
+
+  auto* result = fetch_couchbase_transaction_query_result_from_resource(query_result);
+  if (result == nullptr) {
+    RETURN_THROWS();
+  }
+  if (auto e = result->next_batch(return_value, limit); e.ec) {
+    couchbase_throw_exception(e);
+    RETURN_THROWS();
+  }
+}
+
+PHP_FUNCTION(transactionQueryMetaData)
+{
+  zval* query_result = nullptr;
+
+  ZEND_PARSE_PARAMETERS_START(1, 1)
+  Z_PARAM_RESOURCE(query_result)
+  ZEND_PARSE_PARAMETERS_END();
+
+  logger_flusher guard;
+
+  auto* result = fetch_couchbase_transaction_query_result_from_resource(query_result);
+  if (result == nullptr) {
+    RETURN_THROWS();
+  }
+  result->meta_data(return_value);
+}
+
 PHP_FUNCTION(userUpsert)
 {
   zval* connection = nullptr;
@@ -4174,6 +4493,14 @@ PHP_FUNCTION(coreMeterRecordOperationDuration)
   handle->record_core_meter_operation_duration(value, tags);
 }
 
+PHP_FUNCTION(coreMeteredOperations)
+{
+  if (zend_parse_parameters_none_throw() == FAILURE) {
+    RETURN_THROWS();
+  }
+  couchbase::php::core_metered_operations_to_zval(return_value);
+}
+
 static PHP_MINFO_FUNCTION(couchbase)
 {
   php_info_print_table_start();
@@ -4198,6 +4525,15 @@ ZEND_BEGIN_ARG_INFO_EX(ai_CouchbaseExtension_notifyFork, 0, 0, 1)
 ZEND_ARG_TYPE_INFO(0, forkEvent, IS_STRING, 0)
 ZEND_END_ARG_INFO()
 
+ZEND_BEGIN_ARG_INFO_EX(ai_CouchbaseExtension_droppedLogMessages, 0, 0, 0)
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_INFO_EX(ai_CouchbaseExtension_sharedMetricsSnapshot, 0, 0, 0)
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_INFO_EX(ai_CouchbaseExtension_sharedMetricsOpenMetrics, 0, 0, 0)
+ZEND_END_ARG_INFO()
+
 ZEND_BEGIN_ARG_INFO_EX(ai_CouchbaseExtension_loadExceptionAliases, 0, 0, 0)
 ZEND_END_ARG_INFO()
 
@@ -4213,6 +4549,14 @@ ZEND_BEGIN_ARG_INFO_EX(ai_CouchbaseExtension_clusterLabels, 0, 0, 1)
 ZEND_ARG_INFO(0, connection)
 ZEND_END_ARG_INFO()
 
+ZEND_BEGIN_ARG_INFO_EX(ai_CouchbaseExtension_metricsSnapshot, 0, 0, 1)
+ZEND_ARG_INFO(0, connection)
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_INFO_EX(ai_CouchbaseExtension_metricsOpenMetrics, 0, 0, 1)
+ZEND_ARG_INFO(0, connection)
+ZEND_END_ARG_INFO()
+
 ZEND_BEGIN_ARG_INFO_EX(ai_CouchbaseExtension_replicasConfiguredForBucket, 0, 0, 2)
 ZEND_ARG_INFO(0, connection)
 ZEND_ARG_TYPE_INFO(0, bucketName, IS_STRING, 0)
@@ -4234,6 +4578,11 @@ ZEND_ARG_INFO(0, connection)
 ZEND_ARG_TYPE_INFO(0, bucketName, IS_STRING, 0)
 ZEND_END_ARG_INFO()
 
+ZEND_BEGIN_ARG_INFO_EX(ai_CouchbaseExtension_prepareForkTemplate, 0, 0, 2)
+ZEND_ARG_INFO(0, connection)
+ZEND_ARG_TYPE_INFO(0, bucketNames, IS_ARRAY, 0)
+ZEND_END_ARG_INFO()
+
 ZEND_BEGIN_ARG_INFO_EX(ai_CouchbaseExtension_authenticatorSet, 0, 0, 2)
 ZEND_ARG_INFO(0, connection)
 ZEND_ARG_TYPE_INFO(0, authenticator, IS_ARRAY, 0)
@@ -4472,6 +4821,16 @@ ZEND_BEGIN_ARG_INFO_EX(ai_CouchbaseExtension_documentScanNextItem, 0, 0, 1)
 ZEND_ARG_INFO(0, scan_result)
 ZEND_END_ARG_INFO()
 
+ZEND_BEGIN_ARG_INFO_EX(ai_CouchbaseExtension_documentScanNextBatch, 0, 0, 2)
+ZEND_ARG_INFO(0, scan_result)
+ZEND_ARG_TYPE_INFO(0, limit, IS_LONG, 0)
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_INFO_EX(ai_CouchbaseExtension_documentScanCheckpoint, 0, 0, 2)
+ZEND_ARG_INFO(0, scan_result)
+ZEND_ARG_TYPE_INFO(0, processed_items, IS_LONG, 0)
+ZEND_END_ARG_INFO()
+
 ZEND_BEGIN_ARG_INFO_EX(ai_CouchbaseExtension_documentGetMulti, 0, 0, 5)
 ZEND_ARG_INFO(0, connection)
 ZEND_ARG_TYPE_INFO(0, bucket, IS_STRING, 0)
@@ -4860,6 +5219,12 @@ ZEND_ARG_INFO(0, transactions)
 ZEND_ARG_TYPE_INFO(0, configuration, IS_ARRAY, 1)
 ZEND_END_ARG_INFO()
 
+ZEND_BEGIN_ARG_INFO_EX(ai_CouchbaseExtension_transactionRun, 0, 0, 2)
+ZEND_ARG_INFO(0, transactions)
+ZEND_ARG_TYPE_INFO(0, logic, IS_CALLABLE, 0)
+ZEND_ARG_TYPE_INFO(0, configuration, IS_ARRAY, 1)
+ZEND_END_ARG_INFO()
+
 ZEND_BEGIN_ARG_INFO_EX(ai_CouchbaseExtension_transactionNewAttempt, 0, 0, 1)
 ZEND_ARG_INFO(0, transactions)
 ZEND_END_ARG_INFO()
@@ -4925,12 +5290,32 @@ ZEND_ARG_INFO(0, transactions)
 ZEND_ARG_TYPE_INFO(0, document, IS_ARRAY, 0)
 ZEND_END_ARG_INFO()
 
+ZEND_BEGIN_ARG_INFO_EX(ai_CouchbaseExtension_transactionStageMulti, 0, 0, 2)
+ZEND_ARG_INFO(0, transactions)
+ZEND_ARG_TYPE_INFO(0, mutations, IS_ARRAY, 0)
+ZEND_END_ARG_INFO()
+
 ZEND_BEGIN_ARG_INFO_EX(ai_CouchbaseExtension_transactionQuery, 0, 0, 2)
 ZEND_ARG_INFO(0, transactions)
 ZEND_ARG_TYPE_INFO(0, statement, IS_STRING, 0)
 ZEND_ARG_TYPE_INFO(0, options, IS_ARRAY, 1)
 ZEND_END_ARG_INFO()
 
+ZEND_BEGIN_ARG_INFO_EX(ai_CouchbaseExtension_transactionQueryRows, 0, 0, 2)
+ZEND_ARG_INFO(0, transactions)
+ZEND_ARG_TYPE_INFO(0, statement, IS_STRING, 0)
+ZEND_ARG_TYPE_INFO(0, options, IS_ARRAY, 1)
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_INFO_EX(ai_CouchbaseExtension_transactionQueryNextBatch, 0, 0, 2)
+ZEND_ARG_INFO(0, query_result)
+ZEND_ARG_TYPE_INFO(0, limit, IS_LONG, 0)
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_INFO_EX(ai_CouchbaseExtension_transactionQueryMetaData, 0, 0, 1)
+ZEND_ARG_INFO(0, query_result)
+ZEND_END_ARG_INFO()
+
 ZEND_BEGIN_ARG_INFO_EX(ai_CouchbaseExtension_userUpsert, 0, 0, 2)
 ZEND_ARG_INFO(0, connection)
 ZEND_ARG_TYPE_INFO(0, user, IS_ARRAY, 0)
@@ -5226,18 +5611,27 @@ ZEND_ARG_TYPE_INFO(0, duration_us, IS_LONG, 0)
 ZEND_ARG_TYPE_INFO(0, tags, IS_ARRAY, 0)
 ZEND_END_ARG_INFO()
 
+ZEND_BEGIN_ARG_INFO_EX(ai_CouchbaseExtension_coreMeteredOperations, 0, 0, 0)
+ZEND_END_ARG_INFO()
+
 // clang-format off
 static zend_function_entry couchbase_functions[] = {
         ZEND_NS_FE("Couchbase\\Extension" COUCHBASE_NAMESPACE_ABI_SUFFIX, notifyFork, ai_CouchbaseExtension_notifyFork)
+        ZEND_NS_FE("Couchbase\\Extension" COUCHBASE_NAMESPACE_ABI_SUFFIX, droppedLogMessages, ai_CouchbaseExtension_droppedLogMessages)
+        ZEND_NS_FE("Couchbase\\Extension" COUCHBASE_NAMESPACE_ABI_SUFFIX, sharedMetricsSnapshot, ai_CouchbaseExtension_sharedMetricsSnapshot)
+        ZEND_NS_FE("Couchbase\\Extension" COUCHBASE_NAMESPACE_ABI_SUFFIX, sharedMetricsOpenMetrics, ai_CouchbaseExtension_sharedMetricsOpenMetrics)
         ZEND_NS_FE("Couchbase\\Extension" COUCHBASE_NAMESPACE_ABI_SUFFIX, loadExceptionAliases, ai_CouchbaseExtension_loadExceptionAliases)
         ZEND_NS_FE("Couchbase\\Extension" COUCHBASE_NAMESPACE_ABI_SUFFIX, allowEnterpriseAnalytics, ai_CouchbaseExtension_allowEnterpriseAnalytics)
         ZEND_NS_FE("Couchbase\\Extension" COUCHBASE_NAMESPACE_ABI_SUFFIX, version, ai_CouchbaseExtension_version)
         ZEND_NS_FE("Couchbase\\Extension" COUCHBASE_NAMESPACE_ABI_SUFFIX, clusterVersion, ai_CouchbaseExtension_clusterVersion)
         ZEND_NS_FE("Couchbase\\Extension" COUCHBASE_NAMESPACE_ABI_SUFFIX, clusterLabels, ai_CouchbaseExtension_clusterLabels)
+        ZEND_NS_FE("Couchbase\\Extension" COUCHBASE_NAMESPACE_ABI_SUFFIX, metricsSnapshot, ai_CouchbaseExtension_metricsSnapshot)
+        ZEND_NS_FE("Couchbase\\Extension" COUCHBASE_NAMESPACE_ABI_SUFFIX, metricsOpenMetrics, ai_CouchbaseExtension_metricsOpenMetrics)
         ZEND_NS_FE("Couchbase\\Extension" COUCHBASE_NAMESPACE_ABI_SUFFIX, replicasConfiguredForBucket, ai_CouchbaseExtension_replicasConfiguredForBucket)
         ZEND_NS_FE("Couchbase\\Extension" COUCHBASE_NAMESPACE_ABI_SUFFIX, createConnection, ai_CouchbaseExtension_createConnection)
         ZEND_NS_FE("Couchbase\\Extension" COUCHBASE_NAMESPACE_ABI_SUFFIX, openBucket, ai_CouchbaseExtension_openBucket)
         ZEND_NS_FE("Couchbase\\Extension" COUCHBASE_NAMESPACE_ABI_SUFFIX, closeBucket, ai_CouchbaseExtension_closeBucket)
+        ZEND_NS_FE("Couchbase\\Extension" COUCHBASE_NAMESPACE_ABI_SUFFIX, prepareForkTemplate, ai_CouchbaseExtension_prepareForkTemplate)
         ZEND_NS_FE("Couchbase\\Extension" COUCHBASE_NAMESPACE_ABI_SUFFIX, authenticatorSet, ai_CouchbaseExtension_authenticatorSet)
         ZEND_NS_FE("Couchbase\\Extension" COUCHBASE_NAMESPACE_ABI_SUFFIX, documentUpsert, ai_CouchbaseExtension_documentUpsert)
         ZEND_NS_FE("Couchbase\\Extension" COUCHBASE_NAMESPACE_ABI_SUFFIX, documentInsert, ai_CouchbaseExtension_documentInsert)
@@ -5259,6 +5653,8 @@ static zend_function_entry couchbase_functions[] = {
         ZEND_NS_FE("Couchbase\\Extension" COUCHBASE_NAMESPACE_ABI_SUFFIX, documentLookupIn, ai_CouchbaseExtension_documentLookupIn)
         ZEND_NS_FE("Couchbase\\Extension" COUCHBASE_NAMESPACE_ABI_SUFFIX, createDocumentScanResult, ai_CouchbaseExtension_createDocumentScanResult)
         ZEND_NS_FE("Couchbase\\Extension" COUCHBASE_NAMESPACE_ABI_SUFFIX, documentScanNextItem, ai_CouchbaseExtension_documentScanNextItem)
+        ZEND_NS_FE("Couchbase\\Extension" COUCHBASE_NAMESPACE_ABI_SUFFIX, documentScanNextBatch, ai_CouchbaseExtension_documentScanNextBatch)
+        ZEND_NS_FE("Couchbase\\Extension" COUCHBASE_NAMESPACE_ABI_SUFFIX, documentScanCheckpoint, ai_CouchbaseExtension_documentScanCheckpoint)
         ZEND_NS_FE("Couchbase\\Extension" COUCHBASE_NAMESPACE_ABI_SUFFIX, documentLookupInAnyReplica, ai_CouchbaseExtension_documentLookupInAnyReplica)
         ZEND_NS_FE("Couchbase\\Extension" COUCHBASE_NAMESPACE_ABI_SUFFIX, documentLookupInAllReplicas, ai_CouchbaseExtension_documentLookupInAllReplicas)
         ZEND_NS_FE("Couchbase\\Extension" COUCHBASE_NAMESPACE_ABI_SUFFIX, documentGetMulti, ai_CouchbaseExtension_documentGetMulti)
@@ -5274,6 +5670,7 @@ static zend_function_entry couchbase_functions[] = {
 
         ZEND_NS_FE("Couchbase\\Extension" COUCHBASE_NAMESPACE_ABI_SUFFIX, createTransactions, ai_CouchbaseExtension_createTransactions)
         ZEND_NS_FE("Couchbase\\Extension" COUCHBASE_NAMESPACE_ABI_SUFFIX, createTransactionContext, ai_CouchbaseExtension_createTransactionContext)
+        ZEND_NS_FE("Couchbase\\Extension" COUCHBASE_NAMESPACE_ABI_SUFFIX, transactionRun, ai_CouchbaseExtension_transactionRun)
         ZEND_NS_FE("Couchbase\\Extension" COUCHBASE_NAMESPACE_ABI_SUFFIX, transactionNewAttempt, ai_CouchbaseExtension_transactionNewAttempt)
         ZEND_NS_FE("Couchbase\\Extension" COUCHBASE_NAMESPACE_ABI_SUFFIX, transactionCommit, ai_CouchbaseExtension_transactionCommit)
         ZEND_NS_FE("Couchbase\\Extension" COUCHBASE_NAMESPACE_ABI_SUFFIX, transactionRollback, ai_CouchbaseExtension_transactionRollback)
@@ -5282,7 +5679,11 @@ static zend_function_entry couchbase_functions[] = {
         ZEND_NS_FE("Couchbase\\Extension" COUCHBASE_NAMESPACE_ABI_SUFFIX, transactionInsert, ai_CouchbaseExtension_transactionInsert)
         ZEND_NS_FE("Couchbase\\Extension" COUCHBASE_NAMESPACE_ABI_SUFFIX, transactionReplace, ai_CouchbaseExtension_transactionReplace)
         ZEND_NS_FE("Couchbase\\Extension" COUCHBASE_NAMESPACE_ABI_SUFFIX, transactionRemove, ai_CouchbaseExtension_transactionRemove)
+        ZEND_NS_FE("Couchbase\\Extension" COUCHBASE_NAMESPACE_ABI_SUFFIX, transactionStageMulti, ai_CouchbaseExtension_transactionStageMulti)
         ZEND_NS_FE("Couchbase\\Extension" COUCHBASE_NAMESPACE_ABI_SUFFIX, transactionQuery, ai_CouchbaseExtension_transactionQuery)
+        ZEND_NS_FE("Couchbase\\Extension" COUCHBASE_NAMESPACE_ABI_SUFFIX, transactionQueryRows, ai_CouchbaseExtension_transactionQueryRows)
+        ZEND_NS_FE("Couchbase\\Extension" COUCHBASE_NAMESPACE_ABI_SUFFIX, transactionQueryNextBatch, ai_CouchbaseExtension_transactionQueryNextBatch)
+        ZEND_NS_FE("Couchbase\\Extension" COUCHBASE_NAMESPACE_ABI_SUFFIX, transactionQueryMetaData, ai_CouchbaseExtension_transactionQueryMetaData)
         ZEND_NS_FE("Couchbase\\Extension" COUCHBASE_NAMESPACE_ABI_SUFFIX, transactionGetMulti, ai_CouchbaseExtension_transactionGetMulti)
         ZEND_NS_FE("Couchbase\\Extension" COUCHBASE_NAMESPACE_ABI_SUFFIX, transactionGetMultiReplicasFromPreferredServerGroup, ai_CouchbaseExtension_transactionGetMultiReplicasFromPreferredServerGroup)
 
@@ -5367,6 +5768,7 @@ static zend_function_entry couchbase_functions[] = {
         ZEND_NS_FE("Couchbase\\Extension" COUCHBASE_NAMESPACE_ABI_SUFFIX, coreSpanEnd, ai_CouchbaseExtension_coreSpanEnd)
         ZEND_NS_FE("Couchbase\\Extension" COUCHBASE_NAMESPACE_ABI_SUFFIX, coreSpanAddTag, ai_CouchbaseExtension_coreSpanAddTag)
         ZEND_NS_FE("Couchbase\\Extension" COUCHBASE_NAMESPACE_ABI_SUFFIX, coreMeterRecordOperationDuration, ai_CouchbaseExtension_coreMeterRecordOperationDuration)
+        ZEND_NS_FE("Couchbase\\Extension" COUCHBASE_NAMESPACE_ABI_SUFFIX, coreMeteredOperations, ai_CouchbaseExtension_coreMeteredOperations)
         PHP_FE_END
 };
 
@@ -26,7 +26,9 @@
 #include <tao/json/value.hpp>
 #include <tao/pegtl/parse_error.hpp>
 
+#include <cstring>
 #include <sstream>
+#include <unordered_map>
 #include <zend_exceptions.h>
 
 COUCHBASE_API
@@ -111,6 +113,34 @@ zend_class_entry* transaction_failed_exception_ce;
 zend_class_entry* transaction_expired_exception_ce;
 zend_class_entry* transaction_commit_ambiguous_exception_ce;
 
+namespace
+{
+/*
+ * Errors of the exceptions, which context has not been requested yet. The PHP arrays for the
+ * context are built only when getContext() is called, or when the properties of the exception are
+ * inspected (var_dump(), serialize(), etc.), because most of the exceptions (e.g. the misses of the
+ * cache-like reads) are caught and discarded without looking at their context.
+ */
+thread_local std::unordered_map<const zend_object*, core_error_info> deferred_error_contexts{};
+
+zend_object_handlers couchbase_exception_handlers;
+
+void
+couchbase_exception_free(zend_object* object)
+{
+  deferred_error_contexts.erase(object);
+  zend_object_std_dtor(object);
+}
+
+auto
+couchbase_exception_get_properties_for(zend_object* object, zend_prop_purpose purpose)
+  -> HashTable*
+{
+  materialize_exception_context(object);
+  return zend_std_get_properties_for(object, purpose);
+}
+} // namespace
+
 COUCHBASE_API
 zend_class_entry*
 couchbase_exception()
@@ -130,6 +160,12 @@ initialize_exceptions(const zend_function_entry* exception_functions)
   couchbase_exception_ce = zend_register_internal_class_ex(&ce, zend_ce_exception);
   zend_declare_property_null(couchbase_exception_ce, ZEND_STRL("context"), ZEND_ACC_PRIVATE);
 
+  /* same as the handlers of Exception, but the context is built on the first access */
+  std::memcpy(&couchbase_exception_handlers, &std_object_handlers, sizeof(zend_object_handlers));
+  couchbase_exception_handlers.clone_obj = nullptr;
+  couchbase_exception_handlers.free_obj = couchbase_exception_free;
+  couchbase_exception_handlers.get_properties_for = couchbase_exception_get_properties_for;
+
   INIT_NS_CLASS_ENTRY(
     ce, "Couchbase\\Exception" COUCHBASE_NAMESPACE_ABI_SUFFIX, "TimeoutException", nullptr);
   timeout_exception_ce = zend_register_internal_class_ex(&ce, couchbase_exception_ce);
@@ -777,9 +813,7 @@ map_error_to_exception(const core_error_info& info)
 }
 
 static void
-common_error_context_to_zval(const common_error_context& ctx,
-                             zval* return_value,
-                             const std::string& /* enhanced_error_message */)
+common_error_context_to_zval(const common_error_context& ctx, zval* return_value)
 {
   if (ctx.last_dispatched_to) {
     add_assoc_stringl(return_value,
@@ -807,21 +841,17 @@ common_error_context_to_zval(const common_error_context& ctx,
 }
 
 static void
-common_http_error_context_to_zval(const common_http_error_context& ctx,
-                                  zval* return_value,
-                                  const std::string& enhanced_error_message)
+common_http_error_context_to_zval(const common_http_error_context& ctx, zval* return_value)
 {
   add_assoc_stringl(
     return_value, "clientContextId", ctx.client_context_id.data(), ctx.client_context_id.size());
   add_assoc_long(return_value, "httpStatus", ctx.http_status);
   add_assoc_stringl(return_value, "httpBody", ctx.http_body.data(), ctx.http_body.size());
-  common_error_context_to_zval(ctx, return_value, enhanced_error_message);
+  common_error_context_to_zval(ctx, return_value);
 }
 
 static void
-error_context_to_zval(const key_value_error_context& ctx,
-                      zval* return_value,
-                      std::string& enhanced_error_message)
+error_context_to_zval(const key_value_error_context& ctx, zval* return_value)
 {
   add_assoc_stringl(return_value, "bucketName", ctx.bucket.data(), ctx.bucket.size());
   add_assoc_stringl(return_value, "collection", ctx.collection.data(), ctx.collection.size());
@@ -852,77 +882,61 @@ error_context_to_zval(const key_value_error_context& ctx,
                       "enhancedErrorReference",
                       ctx.enhanced_error_reference.value().data(),
                       ctx.enhanced_error_reference.value().size());
-    enhanced_error_message.append(fmt::format("ref=\"{}\"", ctx.enhanced_error_reference.value()));
   }
   if (ctx.enhanced_error_context) {
     add_assoc_stringl(return_value,
                       "enhancedErrorContext",
                       ctx.enhanced_error_context.value().data(),
                       ctx.enhanced_error_context.value().size());
-    enhanced_error_message.append(fmt::format("{}ctx=\"{}\"",
-                                              ctx.enhanced_error_reference ? ", " : "",
-                                              ctx.enhanced_error_context.value()));
   }
-  common_error_context_to_zval(ctx, return_value, enhanced_error_message);
+  common_error_context_to_zval(ctx, return_value);
 }
 
 static void
-error_context_to_zval(const query_error_context& ctx,
-                      zval* return_value,
-                      std::string& enhanced_error_message)
+error_context_to_zval(const query_error_context& ctx, zval* return_value)
 {
   add_assoc_long(return_value, "firstErrorCode", ctx.first_error_code);
   add_assoc_stringl(return_value,
                     "firstErrorMessage",
                     ctx.first_error_message.data(),
                     ctx.first_error_message.size());
-  enhanced_error_message =
-    fmt::format("serverError={}, \"{}\"", ctx.first_error_code, ctx.first_error_message);
   add_assoc_stringl(return_value, "statement", ctx.statement.data(), ctx.statement.size());
   if (ctx.parameters) {
     add_assoc_stringl(
       return_value, "parameters", ctx.parameters.value().data(), ctx.parameters.value().size());
   }
-  common_http_error_context_to_zval(ctx, return_value, enhanced_error_message);
+  common_http_error_context_to_zval(ctx, return_value);
 }
 
 static void
-error_context_to_zval(const analytics_error_context& ctx,
-                      zval* return_value,
-                      std::string& enhanced_error_message)
+error_context_to_zval(const analytics_error_context& ctx, zval* return_value)
 {
   add_assoc_long(return_value, "firstErrorCode", ctx.first_error_code);
   add_assoc_stringl(return_value,
                     "firstErrorMessage",
                     ctx.first_error_message.data(),
                     ctx.first_error_message.size());
-  enhanced_error_message =
-    fmt::format("serverError={}, \"{}\"", ctx.first_error_code, ctx.first_error_message);
   add_assoc_stringl(return_value, "statement", ctx.statement.data(), ctx.statement.size());
   if (ctx.parameters) {
     add_assoc_stringl(
       return_value, "parameters", ctx.parameters.value().data(), ctx.parameters.value().size());
   }
-  common_http_error_context_to_zval(ctx, return_value, enhanced_error_message);
+  common_http_error_context_to_zval(ctx, return_value);
 }
 
 static void
-error_context_to_zval(const view_query_error_context& ctx,
-                      zval* return_value,
-                      std::string& enhanced_error_message)
+error_context_to_zval(const view_query_error_context& ctx, zval* return_value)
 {
   add_assoc_stringl(return_value,
                     "designDocumentName",
                     ctx.design_document_name.data(),
                     ctx.design_document_name.size());
   add_assoc_stringl(return_value, "viewName", ctx.view_name.data(), ctx.view_name.size());
-  common_http_error_context_to_zval(ctx, return_value, enhanced_error_message);
+  common_http_error_context_to_zval(ctx, return_value);
 }
 
 static void
-error_context_to_zval(const search_error_context& ctx,
-                      zval* return_value,
-                      std::string& enhanced_error_message)
+error_context_to_zval(const search_error_context& ctx, zval* return_value)
 {
   add_assoc_stringl(return_value, "indexName", ctx.index_name.data(), ctx.index_name.size());
   if (ctx.query) {
@@ -932,34 +946,19 @@ error_context_to_zval(const search_error_context& ctx,
     add_assoc_stringl(
       return_value, "parameters", ctx.parameters.value().data(), ctx.parameters.value().size());
   }
-  common_http_error_context_to_zval(ctx, return_value, enhanced_error_message);
+  common_http_error_context_to_zval(ctx, return_value);
 }
 
-COUCHBASE_API
-void
-error_context_to_zval(const http_error_context& ctx,
-                      zval* return_value,
-                      std::string& enhanced_error_message)
+static void
+error_context_to_zval(const http_error_context& ctx, zval* return_value)
 {
   add_assoc_stringl(return_value, "method", ctx.method.data(), ctx.method.size());
   add_assoc_stringl(return_value, "path", ctx.path.data(), ctx.path.size());
-  try {
-    if (auto json_body = core::utils::json::parse(ctx.http_body); json_body.is_object()) {
-      if (const auto* errors = json_body.find("errors"); errors != nullptr) {
-        enhanced_error_message = "errors=" + core::utils::json::generate(*errors);
-      }
-    }
-  } catch (const tao::pegtl::parse_error&) {
-    /* http body is not a JSON */
-  }
-  common_http_error_context_to_zval(ctx, return_value, enhanced_error_message);
+  common_http_error_context_to_zval(ctx, return_value);
 }
 
-COUCHBASE_API
-void
-error_context_to_zval(const transactions_error_context& ctx,
-                      zval* return_value,
-                      std::string& /* enhanced_error_message */)
+static void
+error_context_to_zval(const transactions_error_context& ctx, zval* return_value)
 {
   if (ctx.cause) {
     add_assoc_stringl(return_value, "cause", ctx.cause->data(), ctx.cause->size());
@@ -985,58 +984,130 @@ error_context_to_zval(const transactions_error_context& ctx,
   }
 }
 
-COUCHBASE_API
-void
-error_context_to_zval(const empty_error_context& /* ctx */,
-                      zval* /* return_value */,
-                      std::string& /* enhanced_error_message */)
+static void
+error_context_to_zval(const empty_error_context& /* ctx */, zval* /* return_value */)
 {
   /* nothing to do */
 }
 
-COUCHBASE_API
-void
-error_context_to_zval(const generic_error_context& ctx,
-                      zval* return_value,
-                      std::string& enhanced_error_message)
+static void
+error_context_to_zval(const generic_error_context& ctx, zval* return_value)
 {
   if (!ctx.message.empty()) {
-    if (!enhanced_error_message.empty()) {
-      enhanced_error_message.append(", ");
-    }
-    enhanced_error_message.append(ctx.message);
     add_assoc_stringl(return_value, "message", ctx.message.data(), ctx.message.size());
   }
   if (!ctx.json_data.empty()) {
-    if (!enhanced_error_message.empty()) {
-      enhanced_error_message.append(", ");
-    }
-    enhanced_error_message.append(ctx.json_data);
     add_assoc_stringl(return_value, "json", ctx.json_data.data(), ctx.json_data.size());
   }
   if (ctx.cause != nullptr) {
     zval cause;
     array_init(&cause);
-    error_context_to_zval(*ctx.cause, &cause, enhanced_error_message);
+    error_context_to_zval(*ctx.cause, &cause);
     add_assoc_zval(return_value, "cause", &cause);
   }
 }
 
-COUCHBASE_API
-void
-error_context_to_zval(const core_error_info& info,
-                      zval* return_value,
-                      std::string& enhanced_error_message)
+static void
+error_context_to_zval(const core_error_info& info, zval* return_value)
 {
   array_init(return_value);
   add_assoc_stringl(return_value, "error", info.message.data(), info.message.size());
   std::visit(
-    [return_value, &enhanced_error_message](const auto& ctx) {
-      error_context_to_zval(ctx, return_value, enhanced_error_message);
+    [return_value](const auto& ctx) {
+      error_context_to_zval(ctx, return_value);
     },
     info.error_context);
 }
 
+/*
+ * The parts of the error context, that are also included into the message of the exception.
+ */
+static void
+append_enhanced_error_message(const key_value_error_context& ctx,
+                              std::string& enhanced_error_message)
+{
+  if (ctx.enhanced_error_reference) {
+    enhanced_error_message.append(fmt::format("ref=\"{}\"", ctx.enhanced_error_reference.value()));
+  }
+  if (ctx.enhanced_error_context) {
+    enhanced_error_message.append(fmt::format("{}ctx=\"{}\"",
+                                              ctx.enhanced_error_reference ? ", " : "",
+                                              ctx.enhanced_error_context.value()));
+  }
+}
+
+static void
+append_enhanced_error_message(const query_error_context& ctx, std::string& enhanced_error_message)
+{
+  enhanced_error_message =
+    fmt::format("serverError={}, \"{}\"", ctx.first_error_code, ctx.first_error_message);
+}
+
+static void
+append_enhanced_error_message(const analytics_error_context& ctx,
+                              std::string& enhanced_error_message)
+{
+  enhanced_error_message =
+    fmt::format("serverError={}, \"{}\"", ctx.first_error_code, ctx.first_error_message);
+}
+
+static void
+append_enhanced_error_message(const http_error_context& ctx, std::string& enhanced_error_message)
+{
+  try {
+    if (auto json_body = core::utils::json::parse(ctx.http_body); json_body.is_object()) {
+      if (const auto* errors = json_body.find("errors"); errors != nullptr) {
+        enhanced_error_message = "errors=" + core::utils::json::generate(*errors);
+      }
+    }
+  } catch (const tao::pegtl::parse_error&) {
+    /* http body is not a JSON */
+  }
+}
+
+static void
+append_enhanced_error_message(const generic_error_context& ctx,
+                              std::string& enhanced_error_message)
+{
+  if (!ctx.message.empty()) {
+    if (!enhanced_error_message.empty()) {
+      enhanced_error_message.append(", ");
+    }
+    enhanced_error_message.append(ctx.message);
+  }
+  if (!ctx.json_data.empty()) {
+    if (!enhanced_error_message.empty()) {
+      enhanced_error_message.append(", ");
+    }
+    enhanced_error_message.append(ctx.json_data);
+  }
+  if (ctx.cause != nullptr) {
+    append_enhanced_error_message(*ctx.cause, enhanced_error_message);
+  }
+}
+
+template<typename Context>
+static void
+append_enhanced_error_message(const Context& /* ctx */, std::string& /* enhanced_error_message */)
+{
+  /* the message of the exception does not include anything from this context */
+}
+
+COUCHBASE_API
+void
+materialize_exception_context(zend_object* object)
+{
+  auto it = deferred_error_contexts.find(object);
+  if (it == deferred_error_contexts.end()) {
+    return;
+  }
+  zval context;
+  error_context_to_zval(it->second, &context);
+  deferred_error_contexts.erase(it);
+  zend_update_property(couchbase_exception_ce, object, ZEND_STRL("context"), &context);
+  Z_DELREF(context);
+}
+
 COUCHBASE_API
 void
 create_exception(zval* return_value, const core_error_info& error_info)
@@ -1045,9 +1116,12 @@ create_exception(zval* return_value, const core_error_info& error_info)
     return; // success
   }
 
-  zval context;
   std::string enhanced_error_message;
-  couchbase::php::error_context_to_zval(error_info, &context, enhanced_error_message);
+  std::visit(
+    [&enhanced_error_message](const auto& ctx) {
+      append_enhanced_error_message(ctx, enhanced_error_message);
+    },
+    error_info.error_context);
 
   zend_class_entry* ex_ce = couchbase::php::map_error_to_exception(error_info);
   object_init_ex(return_value, ex_ce);
@@ -1064,8 +1138,8 @@ create_exception(zval* return_value, const core_error_info& error_info)
     ex_ce, return_value, "file", error_info.location.file_name.c_str());
   couchbase_update_property_long(ex_ce, return_value, "line", error_info.location.line);
   couchbase_update_property_long(ex_ce, return_value, "code", error_info.ec.value());
-  couchbase_update_property(couchbase_exception_ce, return_value, "context", &context);
-  Z_DELREF(context);
+  deferred_error_contexts.insert_or_assign(Z_OBJ_P(return_value), error_info);
+  Z_OBJ_P(return_value)->handlers = &couchbase_exception_handlers;
 }
 
 COUCHBASE_API
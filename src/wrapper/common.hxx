@@ -33,10 +33,20 @@ char* log_level{ nullptr };
 char* log_path{ nullptr };
 bool log_php_log_err{ 1 };
 bool log_stderr{ 0 };
+zend_long log_queue_size{ 4096 }; /* maximum number of messages deferred for php_log_err() */
+char* log_queue_policy{ nullptr }; /* "drop_newest" or "drop_oldest" */
+char* log_categories{ nullptr };   /* levels per category, e.g. "io=info,wrapper=debug" */
+zend_long log_rate_limit{ 0 };     /* messages per second per call site, 0 means "no limit" */
+char* metrics_shm_name{ nullptr }; /* shared memory segment for metrics, empty means "disabled" */
+zend_long metrics_shm_slots{ 64 }; /* maximum number of processes writing into the segment */
+char* otlp_endpoint{ nullptr };     /* "file://..." or "unix://...", empty means "disabled" */
+char* otlp_service_name{ nullptr }; /* value of "service.name" resource attribute */
+zend_long otlp_queue_size{ 2048 };  /* maximum number of operations waiting for the export */
 zend_long max_persistent{ -1 }; /* maximum number of persistent connections per process */
 zend_long persistent_timeout{
   -1
 }; /* time period after which idle persistent connection is considered expired */
+bool fork_handlers{ 0 }; /* invoke notifyFork() logic automatically using pthread_atfork() */
 /* module variables */
 bool initialized{ 0 };
 zend_long num_persistent{ 0 }; /* number of existing persistent connections */
@@ -72,6 +82,9 @@ map_error_to_exception(const core_error_info& info);
 COUCHBASE_API void
 create_exception(zval* return_value, const couchbase::php::core_error_info& error_info);
 
+COUCHBASE_API void
+materialize_exception_context(zend_object* object);
+
 COUCHBASE_API void
 allow_enterprise_analytics();
 
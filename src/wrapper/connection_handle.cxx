@@ -22,6 +22,8 @@
 #include "connection_handle.hxx"
 #include "conversion_utilities.hxx"
 #include "logger.hxx"
+#include "operation_metrics.hxx"
+#include "otlp_exporter.hxx"
 #include "passthrough_transcoder.hxx"
 #include "version.hxx"
 
@@ -45,6 +47,7 @@
 #include <core/operations/management/user.hxx>
 #include <core/operations/management/view.hxx>
 #include <core/tracing/wrapper_sdk_tracer.hxx>
+#include <core/transactions.hxx>
 #include <core/utils/connection_string.hxx>
 #include <core/utils/json.hxx>
 
@@ -57,7 +60,22 @@
 
 #include <spdlog/fmt/bundled/core.h>
 
+#include <algorithm>
 #include <array>
+#include <atomic>
+#include <chrono>
+#include <iterator>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 namespace couchbase::php
 {
@@ -333,42 +351,59 @@ build_error_context(const core::error_context::http& ctx) -> http_error_context
   return out;
 }
 
-void
-core_span_to_zval(const std::shared_ptr<core::tracing::wrapper_sdk_span>& span, zval* result)
+/* span names and attribute keys come from the small fixed set, so they are shared between spans */
+auto
+intern_span_string(const std::string& value) -> zend_string*
 {
-  array_init(result);
-
-  add_assoc_string(result, "name", span->name().c_str());
+  return zend_string_init_interned(value.data(), value.size(), 0);
+}
 
+/*
+ * The span is exported as the packed array [name, parent, start_ns, end_ns, attributes], where the
+ * parent is the index of the parent span in the same list, or -1 for the spans of the operation
+ * itself (see ObservabilityHandler::createSpansFromCore()).
+ */
+void
+core_span_to_zval(const std::shared_ptr<core::tracing::wrapper_sdk_span>& span,
+                  zend_long parent,
+                  zval* result)
+{
+  array_init_size(result, 5);
+
+  zval name;
+  ZVAL_STR(&name, intern_span_string(span->name()));
+  add_next_index_zval(result, &name);
+  add_next_index_long(result, parent);
+  add_next_index_long(
+    result,
+    static_cast<zend_long>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(span->start_time().time_since_epoch())
+        .count()));
+  add_next_index_long(
+    result,
+    static_cast<zend_long>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(span->end_time().time_since_epoch())
+        .count()));
+
+  const auto& uint_tags = span->uint_tags();
+  const auto& string_tags = span->string_tags();
   zval attributes;
-  array_init(&attributes);
-  for (const auto& [key, value] : span->uint_tags()) {
-    add_assoc_long(&attributes, key.c_str(), static_cast<zend_long>(value));
-  }
-  for (const auto& [key, value] : span->string_tags()) {
-    add_assoc_string(&attributes, key.c_str(), value.c_str());
+  array_init_size(&attributes, static_cast<uint32_t>(uint_tags.size() + string_tags.size()));
+  for (const auto& [key, value] : uint_tags) {
+    zval tag;
+    ZVAL_LONG(&tag, static_cast<zend_long>(value));
+    auto* interned_key = intern_span_string(key);
+    zend_symtable_update(Z_ARRVAL(attributes), interned_key, &tag);
+    zend_string_release(interned_key);
   }
-  add_assoc_zval(result, "attributes", &attributes);
-
-  auto start_ns =
-    std::chrono::duration_cast<std::chrono::nanoseconds>(span->start_time().time_since_epoch())
-      .count();
-  add_assoc_long(result, "start_timestamp", static_cast<zend_long>(start_ns));
-
-  auto end_ns =
-    std::chrono::duration_cast<std::chrono::nanoseconds>(span->end_time().time_since_epoch())
-      .count();
-  add_assoc_long(result, "end_timestamp", static_cast<zend_long>(end_ns));
-
-  zval children;
-  auto child_spans = span->children();
-  array_init_size(&children, child_spans.size());
-  for (const auto& child : child_spans) {
-    zval child_zval;
-    core_span_to_zval(child, &child_zval);
-    add_next_index_zval(&children, &child_zval);
+  for (const auto& [key, value] : string_tags) {
+    zval tag;
+    ZVAL_STRINGL(&tag, value.data(), value.size());
+    auto* interned_key = intern_span_string(key);
+    zend_symtable_update(Z_ARRVAL(attributes), interned_key, &tag);
+    zend_string_release(interned_key);
   }
-  add_assoc_zval(result, "children", &children);
+  add_next_index_zval(result, &attributes);
 }
 
 void
@@ -388,12 +423,164 @@ populate_core_spans_array(const std::shared_ptr<core::tracing::wrapper_sdk_span>
   // Not having this causes sigbus...
   SEPARATE_ARRAY(spans_array);
 
-  auto children = parent_span->children();
-  for (const auto& child : children) {
-    zval child_span_zval;
-    core_span_to_zval(child, &child_span_zval);
-    add_next_index_zval(spans_array, &child_span_zval);
+  /* the tree is flattened in pre-order, so that every span follows its parent */
+  using pending_span = std::pair<std::shared_ptr<core::tracing::wrapper_sdk_span>, zend_long>;
+  std::vector<pending_span> pending{};
+  auto push_children = [&pending](const std::shared_ptr<core::tracing::wrapper_sdk_span>& span,
+                                  zend_long index) {
+    auto children = span->children();
+    for (auto it = children.rbegin(); it != children.rend(); ++it) {
+      pending.emplace_back(std::move(*it), index);
+    }
+  };
+  push_children(parent_span, -1);
+  while (!pending.empty()) {
+    auto [span, parent] = std::move(pending.back());
+    pending.pop_back();
+    auto index = static_cast<zend_long>(zend_hash_num_elements(Z_ARRVAL_P(spans_array)));
+    zval span_zval;
+    core_span_to_zval(span, parent, &span_zval);
+    add_next_index_zval(spans_array, &span_zval);
+    push_children(span, index);
+  }
+}
+
+/* names of the services follow the values accepted by ping() */
+auto
+service_type_name(core::service_type type) -> std::string_view
+{
+  switch (type) {
+    case core::service_type::key_value:
+      return "kv";
+    case core::service_type::query:
+      return "query";
+    case core::service_type::analytics:
+      return "analytics";
+    case core::service_type::search:
+      return "search";
+    case core::service_type::view:
+      return "views";
+    case core::service_type::management:
+      return "mgmt";
+    case core::service_type::eventing:
+      return "eventing";
+  }
+  return "unknown";
+}
+
+template<typename Request, typename = void>
+struct has_service_type : std::false_type {
+};
+
+template<typename Request>
+struct has_service_type<Request, std::void_t<decltype(Request::type)>> : std::true_type {
+};
+
+template<typename Request, typename = void>
+struct has_document_id : std::false_type {
+};
+
+template<typename Request>
+struct has_document_id<Request, std::void_t<decltype(std::declval<const Request&>().id.bucket())>>
+  : std::true_type {
+};
+
+template<typename Request, typename = void>
+struct has_bucket_name : std::false_type {
+};
+
+template<typename Request>
+struct has_bucket_name<Request, std::void_t<decltype(std::declval<const Request&>().bucket_name)>>
+  : std::true_type {
+};
+
+template<typename Request>
+auto
+request_service_name() -> std::string_view
+{
+  if constexpr (has_service_type<Request>::value) {
+    return service_type_name(Request::type);
+  }
+  return "http";
+}
+
+/* the bucket to group the metrics of the operation by, if the request targets one */
+template<typename Request>
+auto
+request_bucket_name(const Request& request) -> std::string_view
+{
+  if constexpr (has_document_id<Request>::value) {
+    return request.id.bucket();
+  } else if constexpr (has_bucket_name<Request>::value) {
+    using bucket_name_type = std::decay_t<decltype(request.bucket_name)>;
+    if constexpr (std::is_same_v<bucket_name_type, std::string>) {
+      return request.bucket_name;
+    } else if constexpr (std::is_same_v<bucket_name_type, std::optional<std::string>>) {
+      if (request.bucket_name.has_value()) {
+        return request.bucket_name.value();
+      }
+    }
+  }
+  return {};
+}
+
+auto
+make_operation_outcome(std::error_code ec, std::size_t retry_attempts) -> operation_outcome
+{
+  return {
+    static_cast<bool>(ec),
+    ec == errc::common::unambiguous_timeout || ec == errc::common::ambiguous_timeout,
+    retry_attempts,
+  };
+}
+
+/*
+ * Operations, whose durations are recorded into the meter of the core by the extension itself: the
+ * name of the method of connection_handle, and the name of the operation as reported by the SDK
+ * meters (see ObservabilityConstants::OP_*). PHP asks for the list with coreMeteredOperations(), so
+ * that ObservabilityHandler does not record the same operations again.
+ */
+constexpr std::array<std::pair<std::string_view, std::string_view>, 28> core_metered_operations{ {
+  { "document_append", "append" },
+  { "document_decrement", "decrement" },
+  { "document_exists", "exists" },
+  { "document_get", "get" },
+  { "document_get_all_replicas", "get_all_replicas" },
+  { "document_get_and_lock", "get_and_lock" },
+  { "document_get_and_touch", "get_and_touch" },
+  { "document_get_any_replica", "get_any_replica" },
+  { "document_get_multi", "get_multi" },
+  { "document_increment", "increment" },
+  { "document_insert", "insert" },
+  { "document_lookup_in", "lookup_in" },
+  { "document_lookup_in_all_replicas", "lookup_in_all_replicas" },
+  { "document_lookup_in_any_replica", "lookup_in_any_replica" },
+  { "document_mutate_in", "mutate_in" },
+  { "document_prepend", "prepend" },
+  { "document_remove", "remove" },
+  { "document_remove_multi", "remove_multi" },
+  { "document_replace", "replace" },
+  { "document_touch", "touch" },
+  { "document_unlock", "unlock" },
+  { "document_upsert", "upsert" },
+  { "document_upsert_multi", "upsert_multi" },
+  { "query", "query" },
+  { "search", "search" },
+  { "search_query", "search" },
+  { "analytics_query", "analytics" },
+  { "view_query", "views" },
+} };
+
+/* returns empty name, if the duration of the operation is recorded by the meter in PHP */
+auto
+core_meter_operation_name(std::string_view operation) -> std::string_view
+{
+  for (const auto& [method, name] : core_metered_operations) {
+    if (method == operation) {
+      return name;
+    }
   }
+  return {};
 }
 } // namespace
 
@@ -402,10 +589,12 @@ class connection_handle::impl : public std::enable_shared_from_this<connection_h
 public:
   impl(std::string connection_string,
        couchbase::cluster_options cluster_options,
-       std::shared_ptr<core::tracing::wrapper_sdk_tracer> external_tracer)
+       std::shared_ptr<core::tracing::wrapper_sdk_tracer> external_tracer,
+       std::optional<std::chrono::milliseconds> core_spans_sampling_threshold)
     : connection_string_{ std::move(connection_string) }
     , cluster_options_{ std::move(cluster_options) }
     , external_tracer_{ std::move(external_tracer) }
+    , core_spans_sampling_threshold_{ core_spans_sampling_threshold }
   {
   }
 
@@ -424,6 +613,15 @@ public:
 
   void stop()
   {
+    forget_open_buckets();
+    /* transactions run cleanup in the background, so they have to stop before the cluster */
+    std::vector<cached_transactions> transactions;
+    {
+      std::scoped_lock lock(transactions_mutex_);
+      std::swap(transactions, transactions_);
+      evicted_transactions_.clear();
+    }
+    transactions.clear();
     if (auto cluster = std::move(cluster_); cluster) {
       auto barrier = std::make_shared<std::promise<void>>();
       auto f = barrier->get_future();
@@ -462,15 +660,35 @@ public:
     if (auto e = bucket_open(bucket_name); e.ec) {
       return false;
     }
+    auto [ec, config] = bucket_configuration(bucket_name);
+    return !ec && config->num_replicas && config->num_replicas > 0 &&
+           config->nodes.size() > config->num_replicas;
+  }
+
+  auto bucket_configuration(const std::string& bucket_name)
+    -> std::pair<std::error_code, std::shared_ptr<core::topology::configuration>>
+  {
     auto barrier = std::make_shared<
       std::promise<std::pair<std::error_code, std::shared_ptr<core::topology::configuration>>>>();
     auto f = barrier->get_future();
     core_api().with_bucket_configuration(bucket_name, [barrier](std::error_code ec, auto config) {
       barrier->set_value({ ec, std::move(config) });
     });
-    auto [ec, config] = f.get();
-    return !ec && config->num_replicas && config->num_replicas > 0 &&
-           config->nodes.size() > config->num_replicas;
+    return f.get();
+  }
+
+  auto prepare_fork_template(const std::vector<std::string>& bucket_names) -> core_error_info
+  {
+    for (const auto& name : bucket_names) {
+      if (auto e = bucket_open(name); e.ec) {
+        return e;
+      }
+    }
+    if (auto e = await_fork_template_configurations(); e.ec) {
+      return e;
+    }
+    fork_template_ = true;
+    return {};
   }
 
   auto open() -> core_error_info
@@ -497,6 +715,10 @@ public:
 
   auto bucket_open(const std::string& name) -> core_error_info
   {
+    if (is_bucket_open(name)) {
+      /* the bucket has been opened and configured already, no need to cross into I/O thread */
+      return {};
+    }
     auto barrier = std::make_shared<std::promise<std::error_code>>();
     auto f = barrier->get_future();
     core_api().open_bucket(name, [barrier](std::error_code ec) {
@@ -505,11 +727,13 @@ public:
     if (auto ec = f.get()) {
       return { ec, { __LINE__, __FILE__, __func__ } };
     }
+    remember_open_bucket(name);
     return {};
   }
 
   auto bucket_close(const std::string& name) -> core_error_info
   {
+    forget_open_bucket(name);
     auto barrier = std::make_shared<std::promise<std::error_code>>();
     auto f = barrier->get_future();
     core_api().close_bucket(name, [barrier](std::error_code ec) {
@@ -521,23 +745,46 @@ public:
     return {};
   }
 
+  auto is_bucket_open(const std::string& name) const -> bool
+  {
+    auto open_buckets = std::atomic_load(&open_buckets_);
+    return open_buckets != nullptr && open_buckets->count(name) > 0;
+  }
+
   template<typename Request, typename Response = typename Request::response_type>
   auto key_value_execute(const char* operation, Request request, zval* spans)
     -> std::pair<Response, core_error_info>
   {
     std::shared_ptr<core::tracing::wrapper_sdk_span> parent_span{};
-    if (buffering_core_spans() && spans != nullptr) {
+    otlp_operation exported_operation{};
+    if (buffering_core_spans() && (spans != nullptr || otlp_exporter_)) {
       parent_span = std::make_shared<couchbase::core::tracing::wrapper_sdk_span>();
       request.parent_span = parent_span;
+      if (otlp_exporter_) {
+        exported_operation = {
+          "kv",
+          operation,
+          std::string{ request_bucket_name(request) },
+          std::chrono::system_clock::now(),
+        };
+      }
     }
+    auto& group = metrics_.group("kv", operation, request_bucket_name(request));
+    group.start();
+    auto start = std::chrono::steady_clock::now();
     auto barrier = std::make_shared<std::promise<Response>>();
     auto f = barrier->get_future();
     core_api().execute(std::move(request), [barrier](Response&& resp) {
       barrier->set_value(std::move(resp));
     });
     auto resp = f.get();
-    if (buffering_core_spans() && spans != nullptr) {
-      populate_core_spans_array(parent_span, spans);
+    auto latency = std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now() - start);
+    group.finish(latency, make_operation_outcome(resp.ctx.ec(), resp.ctx.retry_attempts()));
+    record_core_meter("kv", operation, latency);
+    if (parent_span) {
+      collect_core_spans(
+        std::move(parent_span), spans, std::move(exported_operation), resp.ctx.ec(), latency);
     }
     if (resp.ctx.ec()) {
       return { std::move(resp),
@@ -554,18 +801,36 @@ public:
     -> std::pair<Response, core_error_info>
   {
     std::shared_ptr<core::tracing::wrapper_sdk_span> parent_span{};
-    if (buffering_core_spans() && spans != nullptr) {
+    otlp_operation exported_operation{};
+    if (buffering_core_spans() && (spans != nullptr || otlp_exporter_)) {
       parent_span = std::make_shared<couchbase::core::tracing::wrapper_sdk_span>();
       request.parent_span = parent_span;
+      if (otlp_exporter_) {
+        exported_operation = {
+          request_service_name<Request>(),
+          operation,
+          std::string{ request_bucket_name(request) },
+          std::chrono::system_clock::now(),
+        };
+      }
     }
+    auto& group =
+      metrics_.group(request_service_name<Request>(), operation, request_bucket_name(request));
+    group.start();
+    auto start = std::chrono::steady_clock::now();
     auto barrier = std::make_shared<std::promise<Response>>();
     auto f = barrier->get_future();
     core_api().execute(std::move(request), [barrier](Response&& resp) {
       barrier->set_value(std::move(resp));
     });
     auto resp = f.get();
-    if (buffering_core_spans() && spans != nullptr) {
-      populate_core_spans_array(parent_span, spans);
+    auto latency = std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now() - start);
+    group.finish(latency, make_operation_outcome(resp.ctx.ec, resp.ctx.retry_attempts));
+    record_core_meter(request_service_name<Request>(), operation, latency);
+    if (parent_span) {
+      collect_core_spans(
+        std::move(parent_span), spans, std::move(exported_operation), resp.ctx.ec, latency);
     }
     if (resp.ctx.ec) {
       return { std::move(resp),
@@ -578,15 +843,25 @@ public:
   }
 
   template<typename Request, typename Response = typename Request::response_type>
-  auto key_value_execute_multi(std::vector<Request> requests) -> std::vector<Response>
+  auto key_value_execute_multi(const char* operation, std::vector<Request> requests)
+    -> std::vector<Response>
   {
     std::vector<std::shared_ptr<std::promise<Response>>> barriers;
     barriers.reserve(requests.size());
+    auto batch_start = std::chrono::steady_clock::now();
     for (auto&& request : requests) {
       auto barrier = std::make_shared<std::promise<Response>>();
-      core_api().execute(request, [barrier](Response&& resp) {
-        barrier->set_value(std::move(resp));
-      });
+      /* every operation of the batch is timed individually, when its response arrives */
+      auto* group = &metrics_.group("kv", operation, request_bucket_name(request));
+      group->start();
+      core_api().execute(
+        request,
+        [barrier, group, start = std::chrono::steady_clock::now()](Response&& resp) {
+          group->finish(std::chrono::duration_cast<std::chrono::microseconds>(
+                          std::chrono::steady_clock::now() - start),
+                        make_operation_outcome(resp.ctx.ec(), resp.ctx.retry_attempts()));
+          barrier->set_value(std::move(resp));
+        });
       barriers.emplace_back(barrier);
     }
     std::vector<Response> responses;
@@ -594,6 +869,11 @@ public:
     for (const auto& barrier : barriers) {
       responses.emplace_back(barrier->get_future().get());
     }
+    /* like the meter in PHP, the meter of the core sees the batch as one operation */
+    record_core_meter("kv",
+                      operation,
+                      std::chrono::duration_cast<std::chrono::microseconds>(
+                        std::chrono::steady_clock::now() - batch_start));
     return responses;
   }
 
@@ -648,10 +928,125 @@ public:
     return external_tracer_ != nullptr;
   }
 
+  /*
+   * When the native exporter is configured, the spans are exported from its background thread, and
+   * they are not returned to PHP at all.
+   *
+   * With the sampling threshold, the spans of the successful operations faster than the threshold
+   * are dropped here, so that only the tree recorded by the core is paid for them.
+   */
+  void collect_core_spans(std::shared_ptr<core::tracing::wrapper_sdk_span> parent_span,
+                          zval* spans,
+                          otlp_operation&& exported_operation,
+                          std::error_code ec,
+                          std::chrono::microseconds latency)
+  {
+    if (!ec && core_spans_sampling_threshold_ && latency < core_spans_sampling_threshold_.value()) {
+      return;
+    }
+    if (otlp_exporter_) {
+      exported_operation.end_time = std::chrono::system_clock::now();
+      exported_operation.ec = ec;
+      exported_operation.spans = std::move(parent_span);
+      otlp_exporter_->submit(std::move(exported_operation));
+    } else if (spans != nullptr) {
+      populate_core_spans_array(parent_span, spans);
+    }
+  }
+
+  /*
+   * Records the duration of the operation into the meter of the core (the backend of LoggingMeter,
+   * which is noop unless the core metrics are enabled), so that PHP does not have to cross into the
+   * extension with the tags of every operation. The tags are built once per operation.
+   */
+  void record_core_meter(std::string_view service,
+                         std::string_view operation,
+                         std::chrono::microseconds latency)
+  {
+    const std::map<std::string, std::string>* tags{ nullptr };
+    {
+      std::shared_lock lock(core_meter_tags_mutex_);
+      if (auto it = core_meter_tags_.find(operation); it != core_meter_tags_.end()) {
+        tags = &it->second;
+      }
+    }
+    if (tags == nullptr) {
+      auto name = core_meter_operation_name(operation);
+      std::map<std::string, std::string> operation_tags{};
+      if (!name.empty()) {
+        operation_tags = {
+          { "couchbase.service", std::string{ service } },
+          { "db.operation.name", std::string{ name } },
+        };
+      }
+      std::unique_lock lock(core_meter_tags_mutex_);
+      tags = &core_meter_tags_.try_emplace(std::string{ operation }, std::move(operation_tags))
+                .first->second;
+    }
+    if (!tags->empty()) {
+      core_api().meter()->record_value(*tags, latency);
+    }
+  }
+
+  auto metrics() const -> const operation_metrics&
+  {
+    return metrics_;
+  }
+
+  /*
+   * Returns the transactions object shared by all transactions resources with the same
+   * configuration, so that the cleanup machinery is set up once per persistent connection rather
+   * than once per PHP request. Only a few most recently used configurations are kept, the evicted
+   * object lives until the last resource using it is destroyed, and still receives fork events.
+   */
+  auto transactions(const std::string& config_key,
+                    const couchbase::transactions::transactions_config& config)
+    -> std::shared_ptr<core::transactions::transactions>
+  {
+    std::shared_ptr<core::transactions::transactions> evicted{};
+    std::scoped_lock lock(transactions_mutex_);
+    if (auto it = std::find_if(transactions_.begin(),
+                               transactions_.end(),
+                               [&config_key](const auto& entry) {
+                                 return entry.config_key == config_key;
+                               });
+        it != transactions_.end()) {
+      std::rotate(transactions_.begin(), it, std::next(it));
+      return transactions_.front().transactions;
+    }
+    if (transactions_.size() >= max_cached_transactions) {
+      /* destroyed after the lock is released, as it stops the cleanup */
+      evicted = std::move(transactions_.back().transactions);
+      transactions_.pop_back();
+      evicted_transactions_.erase(std::remove_if(evicted_transactions_.begin(),
+                                                 evicted_transactions_.end(),
+                                                 [](const auto& entry) {
+                                                   return entry.expired();
+                                                 }),
+                                  evicted_transactions_.end());
+      evicted_transactions_.emplace_back(evicted);
+      CB_LOG_DEBUG("evicted least recently used transactions object from the connection");
+    }
+    auto transactions = std::make_shared<core::transactions::transactions>(core_api(), config);
+    transactions_.insert(transactions_.begin(), { config_key, transactions });
+    CB_LOG_DEBUG("created transactions object, {} configuration(s) cached on the connection",
+                 transactions_.size());
+    return transactions;
+  }
+
   void notify_fork(fork_event event)
   {
     switch (event) {
       case fork_event::prepare:
+        /* transactions must be first to stop */
+        notify_transactions(couchbase::fork_event::prepare);
+        if (fork_template_) {
+          if (auto e = await_fork_template_configurations(); e.ec) {
+            CB_LOG_WARNING("Fork template is not ready before fork(): ec={} ({})",
+                           e.ec.message(),
+                           e.message);
+          }
+        }
         cluster_->notify_fork(couchbase::fork_event::prepare);
         CB_LOG_INFO("Prepare for fork()");
         shutdown_logger();
@@ -661,21 +1056,135 @@ public:
         initialize_logger();
         CB_LOG_INFO("Resume parent after fork()");
         cluster_->notify_fork(couchbase::fork_event::parent);
+        notify_transactions(couchbase::fork_event::parent);
         break;
 
       case fork_event::child:
         initialize_logger();
-        CB_LOG_INFO("Resume child after fork()");
+        /* the child claims its own slot of the shared memory segment */
+        metrics_.reattach_mirrors();
+        if (fork_template_) {
+          auto open_buckets = std::atomic_load(&open_buckets_);
+          CB_LOG_INFO("Resume child after fork() using fork template with {} pre-opened bucket(s)",
+                      open_buckets == nullptr ? 0 : open_buckets->size());
+        } else {
+          CB_LOG_INFO("Resume child after fork()");
+        }
         cluster_->notify_fork(couchbase::fork_event::child);
+        /* transactions must be last to start */
+        notify_transactions(couchbase::fork_event::child);
         break;
     }
   }
 
 private:
+  void notify_transactions(couchbase::fork_event event)
+  {
+    std::vector<std::shared_ptr<core::transactions::transactions>> transactions{};
+    {
+      std::scoped_lock lock(transactions_mutex_);
+      for (const auto& entry : transactions_) {
+        transactions.emplace_back(entry.transactions);
+      }
+      /* evicted objects might be still used by the transactions resources */
+      for (const auto& entry : evicted_transactions_) {
+        if (auto evicted = entry.lock(); evicted) {
+          transactions.emplace_back(std::move(evicted));
+        }
+      }
+    }
+    for (const auto& entry : transactions) {
+      entry->notify_fork(event);
+    }
+  }
+
+  /*
+   * The set of the opened buckets is copy-on-write, so that readers (every Cluster::bucket() call)
+   * never take locks, and only rare open/close operations pay for the copy.
+   */
+  void remember_open_bucket(const std::string& name)
+  {
+    auto current = std::atomic_load(&open_buckets_);
+    while (true) {
+      if (current != nullptr && current->count(name) > 0) {
+        return;
+      }
+      auto updated = current == nullptr ? std::make_shared<std::set<std::string>>()
+                                        : std::make_shared<std::set<std::string>>(*current);
+      updated->insert(name);
+      if (std::atomic_compare_exchange_weak(
+            &open_buckets_, &current, std::shared_ptr<const std::set<std::string>>(updated))) {
+        return;
+      }
+    }
+  }
+
+  void forget_open_bucket(const std::string& name)
+  {
+    auto current = std::atomic_load(&open_buckets_);
+    while (current != nullptr && current->count(name) > 0) {
+      auto updated = std::make_shared<std::set<std::string>>(*current);
+      updated->erase(name);
+      if (std::atomic_compare_exchange_weak(
+            &open_buckets_, &current, std::shared_ptr<const std::set<std::string>>(updated))) {
+        return;
+      }
+    }
+  }
+
+  /*
+   * Waits until every opened bucket has its configuration loaded, so that the child processes
+   * inherit the topology and do not need to bootstrap buckets again after fork(). The
+   * configurations are not fetched again here, the core keeps them up to date while the connection
+   * is running.
+   */
+  auto await_fork_template_configurations() -> core_error_info
+  {
+    auto open_buckets = std::atomic_load(&open_buckets_);
+    if (open_buckets == nullptr) {
+      return {};
+    }
+    for (const auto& name : *open_buckets) {
+      auto [ec, config] = bucket_configuration(name);
+      if (ec) {
+        return { ec,
+                 ERROR_LOCATION,
+                 fmt::format(R"(unable to fetch configuration of the bucket "{}")", name) };
+      }
+      CB_LOG_DEBUG("fork template: bucket=\"{}\", config_rev={}, nodes={}",
+                   name,
+                   config->rev_str(),
+                   config->nodes.size());
+    }
+    return {};
+  }
+
+  void forget_open_buckets()
+  {
+    std::atomic_store(&open_buckets_, std::shared_ptr<const std::set<std::string>>{});
+  }
+
   std::string connection_string_;
   couchbase::cluster_options cluster_options_;
   std::unique_ptr<couchbase::cluster> cluster_{ nullptr };
   std::shared_ptr<core::tracing::wrapper_sdk_tracer> external_tracer_{ nullptr };
+  std::optional<std::chrono::microseconds> core_spans_sampling_threshold_{};
+  std::shared_ptr<otlp_exporter> otlp_exporter_{ current_otlp_exporter() };
+  std::shared_ptr<const std::set<std::string>> open_buckets_{ nullptr };
+  bool fork_template_{ false };
+  struct cached_transactions {
+    std::string config_key;
+    std::shared_ptr<core::transactions::transactions> transactions;
+  };
+  static constexpr std::size_t max_cached_transactions{ 8 };
+  std::mutex transactions_mutex_{};
+  /* the most recently used first */
+  std::vector<cached_transactions> transactions_{};
+  std::vector<std::weak_ptr<core::transactions::transactions>> evicted_transactions_{};
+  operation_metrics metrics_{};
+  std::shared_mutex core_meter_tags_mutex_{};
+  /* empty tags mean that the operation is recorded by the meter in PHP */
+  std::map<std::string, std::map<std::string, std::string>, std::less<>> core_meter_tags_{};
 };
 
 COUCHBASE_API
@@ -684,13 +1193,15 @@ connection_handle::connection_handle(
   std::string connection_hash,
   couchbase::cluster_options cluster_options,
   std::chrono::system_clock::time_point idle_expiry,
-  std::shared_ptr<core::tracing::wrapper_sdk_tracer> external_tracer)
+  std::shared_ptr<core::tracing::wrapper_sdk_tracer> external_tracer,
+  std::optional<std::chrono::milliseconds> core_spans_sampling_threshold)
   : idle_expiry_{ idle_expiry }
   , connection_string_(std::move(connection_string))
   , connection_hash_(std::move(connection_hash))
   , impl_{ std::make_shared<connection_handle::impl>(connection_string_,
                                                      std::move(cluster_options),
-                                                     std::move(external_tracer)) }
+                                                     std::move(external_tracer),
+                                                     core_spans_sampling_threshold) }
 {
 }
 
@@ -726,6 +1237,15 @@ connection_handle::notify_fork(fork_event event) const
   return impl_->notify_fork(event);
 }
 
+COUCHBASE_API
+auto
+connection_handle::transactions(const std::string& config_key,
+                                const couchbase::transactions::transactions_config& config)
+  -> std::shared_ptr<core::transactions::transactions>
+{
+  return impl_->transactions(config_key, config);
+}
+
 COUCHBASE_API
 auto
 connection_handle::bucket_open(const std::string& name) -> core_error_info
@@ -740,6 +1260,28 @@ connection_handle::bucket_open(const zend_string* name) -> core_error_info
   return impl_->bucket_open(cb_string_new(name));
 }
 
+COUCHBASE_API
+auto
+connection_handle::prepare_fork_template(const zval* bucket_names) -> core_error_info
+{
+  std::vector<std::string> names{};
+  if (bucket_names != nullptr && Z_TYPE_P(bucket_names) == IS_ARRAY) {
+    names.reserve(zend_hash_num_elements(Z_ARRVAL_P(bucket_names)));
+    const zval* item = nullptr;
+    ZEND_HASH_FOREACH_VAL(Z_ARRVAL_P(bucket_names), item)
+    {
+      if (Z_TYPE_P(item) != IS_STRING) {
+        return { errc::common::invalid_argument,
+                 ERROR_LOCATION,
+                 "expected bucket names to be an array of strings" };
+      }
+      names.emplace_back(cb_string_new(Z_STR_P(item)));
+    }
+    ZEND_HASH_FOREACH_END();
+  }
+  return impl_->prepare_fork_template(names);
+}
+
 COUCHBASE_API
 auto
 connection_handle::bucket_close(const zend_string* name) -> core_error_info
@@ -898,6 +1440,71 @@ is_mutation_token_valid(const mutation_token& token) -> bool
 }
 } // namespace
 
+COUCHBASE_API
+void
+connection_handle::metrics_snapshot(zval* return_value)
+{
+  operation_snapshots_to_zval(return_value, impl_->metrics().take_snapshots());
+}
+
+COUCHBASE_API
+void
+connection_handle::metrics_open_metrics(zval* return_value)
+{
+  std::string out;
+  append_open_metrics(out, impl_->metrics().take_snapshots());
+
+  auto [err, resp] = impl_->diagnostics(fmt::format("{}", static_cast<const void*>(this)));
+  std::map<std::tuple<std::string_view, std::string, std::string_view>, std::size_t> connections;
+  if (!err.ec) {
+    for (const auto& [service_type, service_infos] : resp.services) {
+      for (const auto& svc : service_infos) {
+        std::string_view state{};
+        switch (svc.state) {
+          case core::diag::endpoint_state::disconnected:
+            state = "disconnected";
+            break;
+          case core::diag::endpoint_state::connecting:
+            state = "connecting";
+            break;
+          case core::diag::endpoint_state::connected:
+            state = "connected";
+            break;
+          case core::diag::endpoint_state::disconnecting:
+            state = "disconnecting";
+            break;
+        }
+        ++connections[{ service_type_name(service_type), svc.remote, state }];
+      }
+    }
+  }
+  out += "# TYPE couchbase_connections gauge\n"
+         "# HELP couchbase_connections Number of the connections to the nodes.\n";
+  for (const auto& [labels, count] : connections) {
+    const auto& [service, node, state] = labels;
+    out += "couchbase_connections{service=\"";
+    append_open_metrics_label_value(out, service);
+    out += "\",node=\"";
+    append_open_metrics_label_value(out, node);
+    out += "\",state=\"";
+    append_open_metrics_label_value(out, state);
+    out += fmt::format("\"}} {}\n", count);
+  }
+
+  out += fmt::format("# TYPE couchbase_persistent_connections gauge\n"
+                     "# HELP couchbase_persistent_connections Number of the persistent connections "
+                     "of the process.\n"
+                     "couchbase_persistent_connections {}\n"
+                     "# TYPE couchbase_persistent_connections_limit gauge\n"
+                     "# HELP couchbase_persistent_connections_limit Maximum number of the "
+                     "persistent connections of the process (-1 for unlimited).\n"
+                     "couchbase_persistent_connections_limit {}\n"
+                     "# EOF\n",
+                     COUCHBASE_G(num_persistent),
+                     COUCHBASE_G(max_persistent));
+  RETVAL_STRINGL(out.data(), out.size());
+}
+
 COUCHBASE_API
 void
 connection_handle::cluster_labels(zval* return_value)
@@ -942,6 +1549,16 @@ zval_to_value_recorder_tags(const zval* tags) -> std::map<std::string, std::stri
 }
 } // namespace
 
+COUCHBASE_API
+void
+core_metered_operations_to_zval(zval* return_value)
+{
+  array_init(return_value);
+  for (const auto& [method, name] : core_metered_operations) {
+    add_assoc_bool_ex(return_value, name.data(), name.size(), true);
+  }
+}
+
 COUCHBASE_API
 void
 connection_handle::record_core_meter_operation_duration(std::int64_t duration_us, zval* tags)
@@ -1420,6 +2037,10 @@ connection_handle::document_get(zval* return_value,
   if (auto e = cb_assign_vector_of_strings(projections, options, "projections"); e.ec) {
     return e;
   }
+  bool return_null_on_missing = false;
+  if (auto e = cb_assign_boolean(return_null_on_missing, options, "returnNullOnMissing"); e.ec) {
+    return e;
+  }
 
   if (!with_expiry && projections.empty()) {
     couchbase::core::operations::get_request request{ doc_id };
@@ -1428,6 +2049,10 @@ connection_handle::document_get(zval* return_value,
     }
 
     auto [resp, err] = impl_->key_value_execute(__func__, std::move(request), spans);
+    if (return_null_on_missing && err.ec == errc::key_value::document_not_found) {
+      ZVAL_NULL(return_value);
+      return {};
+    }
     if (err.ec) {
       return err;
     }
@@ -1442,6 +2067,10 @@ connection_handle::document_get(zval* return_value,
     return e;
   }
   auto [resp, err] = impl_->key_value_execute(__func__, std::move(request), spans);
+  if (return_null_on_missing && err.ec == errc::key_value::document_not_found) {
+    ZVAL_NULL(return_value);
+    return {};
+  }
   if (err.ec) {
     return err;
   }
@@ -1960,8 +2589,16 @@ connection_handle::document_lookup_in(zval* return_value,
   if (auto e = cb_assign_lookup_in_specs(req, specs); e.ec) {
     return e;
   }
+  bool return_null_on_missing = false;
+  if (auto e = cb_assign_boolean(return_null_on_missing, options, "returnNullOnMissing"); e.ec) {
+    return e;
+  }
 
   auto [resp, err] = impl_->key_value_execute(__func__, std::move(req), spans);
+  if (return_null_on_missing && err.ec == errc::key_value::document_not_found) {
+    ZVAL_NULL(return_value);
+    return {};
+  }
   if (err.ec) {
     return err;
   }
@@ -2070,6 +2707,10 @@ connection_handle::document_get_multi(zval* return_value,
   if (auto e = cb_assign_timeout(base_req, options); e.ec) {
     return e;
   }
+  bool return_null_on_missing = false;
+  if (auto e = cb_assign_boolean(return_null_on_missing, options, "returnNullOnMissing"); e.ec) {
+    return e;
+  }
   std::vector<couchbase::core::operations::get_request> requests{};
   requests.reserve(zend_array_count(Z_ARRVAL_P(ids)));
   std::vector<const zend_string*> ids_vec{};
@@ -2091,12 +2732,16 @@ connection_handle::document_get_multi(zval* return_value,
     ZEND_HASH_FOREACH_END();
   }
 
-  auto responses = impl_->key_value_execute_multi(std::move(requests));
+  auto responses = impl_->key_value_execute_multi(__func__, std::move(requests));
   array_init_size(return_value, responses.size());
   for (std::size_t i = 0; i < responses.size(); ++i) {
     const auto& resp = responses[i];
     const zend_string* id = ids_vec[i];
 
+    if (return_null_on_missing && resp.ctx.ec() == errc::key_value::document_not_found) {
+      add_next_index_null(return_value);
+      continue;
+    }
     zval entry;
     cb_create_get_result(&entry, resp, id);
     if (resp.ctx.ec()) {
@@ -2215,7 +2860,7 @@ connection_handle::document_remove_multi(zval* return_value,
         legacy_durability.value().second,
       });
     }
-    responses = impl_->key_value_execute_multi(std::move(requests));
+    responses = impl_->key_value_execute_multi(__func__, std::move(requests));
   } else {
     std::vector<couchbase::core::operations::remove_request> requests{};
     requests.reserve(id_cas_pairs.size());
@@ -2230,7 +2875,7 @@ connection_handle::document_remove_multi(zval* return_value,
       req.cas = cas;
       requests.push_back(std::move(req));
     }
-    responses = impl_->key_value_execute_multi(std::move(requests));
+    responses = impl_->key_value_execute_multi(__func__, std::move(requests));
   }
 
   array_init_size(return_value, responses.size());
@@ -2353,7 +2998,7 @@ connection_handle::document_upsert_multi(zval* return_value,
         legacy_durability.value().second,
       });
     }
-    responses = impl_->key_value_execute_multi(std::move(requests));
+    responses = impl_->key_value_execute_multi(__func__, std::move(requests));
   } else {
     std::vector<couchbase::core::operations::upsert_request> requests{};
     requests.reserve(id_value_pairs.size());
@@ -2369,7 +3014,7 @@ connection_handle::document_upsert_multi(zval* return_value,
       req.flags = value.flags;
       requests.push_back(std::move(req));
     }
-    responses = impl_->key_value_execute_multi(std::move(requests));
+    responses = impl_->key_value_execute_multi(__func__, std::move(requests));
   }
 
   array_init_size(return_value, responses.size());
@@ -6550,25 +7195,48 @@ maybe_set_external_tracer(couchbase::cluster_options& cluster_opts, zval* option
     };
   }
 
-  const zval* bufferCoreSpans =
-    zend_symtable_str_find(Z_ARRVAL_P(options), ZEND_STRL("bufferCoreSpans"));
-  if (bufferCoreSpans == nullptr) {
+  bool buffer_core_spans = false;
+  if (const zval* bufferCoreSpans =
+        zend_symtable_str_find(Z_ARRVAL_P(options), ZEND_STRL("bufferCoreSpans"));
+      bufferCoreSpans != nullptr) {
+    switch (Z_TYPE_P(bufferCoreSpans)) {
+      case IS_TRUE:
+        buffer_core_spans = true;
+        break;
+      case IS_FALSE:
+        break;
+      default:
+        return { { errc::common::invalid_argument,
+                   ERROR_LOCATION,
+                   "expected boolean for bufferCoreSpans option" },
+                 nullptr };
+    }
+  }
+  /* the native exporter collects the spans in the same way as they are buffered for PHP */
+  if (!buffer_core_spans && !current_otlp_exporter()) {
     return { {}, nullptr };
   }
-  switch (Z_TYPE_P(bufferCoreSpans)) {
-    case IS_TRUE: {
-      auto tracer = std::make_shared<core::tracing::wrapper_sdk_tracer>();
-      cluster_opts.tracing().tracer(tracer);
-      return { {}, tracer };
-    }
-    case IS_FALSE:
-      return { {}, nullptr };
-    default:
-      return { { errc::common::invalid_argument,
-                 ERROR_LOCATION,
-                 "expected boolean for bufferCoreSpans option" },
-               nullptr };
+  auto tracer = std::make_shared<core::tracing::wrapper_sdk_tracer>();
+  cluster_opts.tracing().tracer(tracer);
+  return { {}, tracer };
+}
+
+auto
+core_spans_sampling_threshold(zval* options)
+  -> std::pair<core_error_info, std::optional<std::chrono::milliseconds>>
+{
+  const zval* threshold =
+    zend_symtable_str_find(Z_ARRVAL_P(options), ZEND_STRL("coreSpansSamplingThreshold"));
+  if (threshold == nullptr || Z_TYPE_P(threshold) == IS_NULL) {
+    return { {}, {} };
   }
+  if (Z_TYPE_P(threshold) != IS_LONG || Z_LVAL_P(threshold) < 0) {
+    return { { errc::common::invalid_argument,
+               ERROR_LOCATION,
+               "expected duration as a non-negative number for coreSpansSamplingThreshold" },
+             {} };
+  }
+  return { {}, std::chrono::milliseconds{ Z_LVAL_P(threshold) } };
 }
 
 auto
@@ -6713,11 +7381,16 @@ create_connection_handle(const zend_string* connection_string,
   if (e3.ec) {
     return { nullptr, e3 };
   }
+  auto [e4, sampling_threshold] = options::core_spans_sampling_threshold(options);
+  if (e4.ec) {
+    return { nullptr, e4 };
+  }
   return { new connection_handle(std::move(connection_str),
                                  std::string(ZSTR_VAL(connection_hash), ZSTR_LEN(connection_hash)),
                                  std::move(cluster_options.value()),
                                  idle_expiry,
-                                 std::move(external_tracer)),
+                                 std::move(external_tracer),
+                                 sampling_threshold),
            {} };
 }
 } // namespace couchbase::php
@@ -26,11 +26,16 @@
 
 #include <chrono>
 #include <memory>
+#include <optional>
 #include <string>
 
 namespace couchbase
 {
 class cluster_options;
+namespace transactions
+{
+class transactions_config;
+} // namespace transactions
 namespace core
 {
 class cluster;
@@ -38,6 +43,10 @@ namespace tracing
 {
 class wrapper_sdk_tracer;
 } // namespace tracing
+namespace transactions
+{
+class transactions;
+} // namespace transactions
 } // namespace core
 } // namespace couchbase
 
@@ -51,7 +60,8 @@ public:
                     std::string connection_hash,
                     couchbase::cluster_options cluster_options,
                     std::chrono::system_clock::time_point idle_expiry,
-                    std::shared_ptr<core::tracing::wrapper_sdk_tracer> external_tracer);
+                    std::shared_ptr<core::tracing::wrapper_sdk_tracer> external_tracer,
+                    std::optional<std::chrono::milliseconds> core_spans_sampling_threshold);
 
   COUCHBASE_API
   connection_handle(const connection_handle&) = delete;
@@ -102,6 +112,11 @@ public:
   COUCHBASE_API
   void notify_fork(fork_event event) const;
 
+  COUCHBASE_API
+  auto transactions(const std::string& config_key,
+                    const couchbase::transactions::transactions_config& config)
+    -> std::shared_ptr<core::transactions::transactions>;
+
   COUCHBASE_API
   auto open() -> core_error_info;
 
@@ -114,6 +129,9 @@ public:
   COUCHBASE_API
   auto bucket_close(const zend_string* name) -> core_error_info;
 
+  COUCHBASE_API
+  auto prepare_fork_template(const zval* bucket_names) -> core_error_info;
+
   COUCHBASE_API
   auto authenticator_set(const zval* authenticator) -> core_error_info;
 
@@ -123,6 +141,20 @@ public:
   COUCHBASE_API
   void record_core_meter_operation_duration(std::int64_t duration_us, zval* tags);
 
+  /**
+   * Returns latency histograms of the operations executed through this connection, grouped by
+   * service, operation and bucket.
+   */
+  COUCHBASE_API
+  void metrics_snapshot(zval* return_value);
+
+  /**
+   * Renders metrics of the operations, connections to the nodes and the pool of persistent
+   * connections in OpenMetrics text format.
+   */
+  COUCHBASE_API
+  void metrics_open_metrics(zval* return_value);
+
   COUCHBASE_API
   auto document_upsert(zval* return_value,
                        zval* spans,
@@ -814,4 +846,12 @@ create_connection_handle(const zend_string* connection_string,
                          zval* options,
                          std::chrono::system_clock::time_point idle_expiry)
   -> std::pair<connection_handle*, core_error_info>;
+
+/**
+ * Fills the array, which is keyed by the names of the operations (see
+ * ObservabilityConstants::OP_*) that the extension records into the meter of the core itself.
+ */
+COUCHBASE_API
+void
+core_metered_operations_to_zval(zval* return_value);
 } // namespace couchbase::php
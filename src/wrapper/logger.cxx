@@ -20,72 +20,392 @@
 #include "logger.hxx"
 
 #include <core/logger/logger.hxx>
-#include <core/utils/json.hxx>
 
 #include <core/logger/configuration.hxx>
 
+#include <spdlog/details/log_msg_buffer.h>
+#include <spdlog/details/null_mutex.h>
 #include <spdlog/details/os.h>
+#include <spdlog/pattern_formatter.h>
 #include <spdlog/sinks/base_sink.h>
+#include <spdlog/sinks/dist_sink.h>
+#include <spdlog/sinks/stdout_color_sinks.h>
 #include <spdlog/spdlog.h>
 
 #include <spdlog/fmt/bundled/chrono.h>
 
 #include <php.h>
 
-#include <tao/json/value.hpp>
-
 #include <algorithm>
-#include <queue>
+#include <atomic>
+#include <chrono>
+#include <cctype>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
 
 namespace couchbase::php
 {
-template<typename Mutex>
-class php_log_err_sink : public spdlog::sinks::base_sink<Mutex>
+namespace
+{
+/*
+ * Fields of the log message, that are rendered into JSON only when the messages are flushed. The
+ * source location points to string literals, so it is safe to keep the pointers.
+ */
+struct log_record {
+  spdlog::level::level_enum level{};
+  spdlog::log_clock::time_point time{};
+  std::size_t thread_id{};
+  std::string payload{};
+  const char* filename{ nullptr };
+  int line{ 0 };
+  const char* funcname{ nullptr };
+};
+
+/*
+ * Bounded multi-producer/multi-consumer queue (D. Vyukov's algorithm). Every slot owns the record
+ * with preallocated payload, so that writing the message reuses the storage of the slot, and the
+ * producers never take locks or allocate memory for regular-sized messages.
+ */
+class log_record_ring
+{
+public:
+  explicit log_record_ring(std::size_t capacity)
+  {
+    std::size_t size = 2;
+    while (size < capacity) {
+      size <<= 1;
+    }
+    mask_ = size - 1;
+    cells_ = std::make_unique<cell[]>(size);
+    for (std::size_t i = 0; i < size; ++i) {
+      cells_[i].sequence.store(i, std::memory_order_relaxed);
+      cells_[i].record.payload.reserve(preallocated_payload_size);
+    }
+  }
+
+  template<typename Writer>
+  auto try_push(Writer&& write) -> bool
+  {
+    auto pos = enqueue_pos_.load(std::memory_order_relaxed);
+    cell* c = nullptr;
+    while (true) {
+      c = &cells_[pos & mask_];
+      auto seq = c->sequence.load(std::memory_order_acquire);
+      auto diff = static_cast<std::intptr_t>(seq) - static_cast<std::intptr_t>(pos);
+      if (diff == 0) {
+        if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = enqueue_pos_.load(std::memory_order_relaxed);
+      }
+    }
+    write(c->record);
+    c->sequence.store(pos + 1, std::memory_order_release);
+    return true;
+  }
+
+  template<typename Reader>
+  auto try_pop(Reader&& read) -> bool
+  {
+    auto pos = dequeue_pos_.load(std::memory_order_relaxed);
+    cell* c = nullptr;
+    while (true) {
+      c = &cells_[pos & mask_];
+      auto seq = c->sequence.load(std::memory_order_acquire);
+      auto diff = static_cast<std::intptr_t>(seq) - static_cast<std::intptr_t>(pos + 1);
+      if (diff == 0) {
+        if (dequeue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = dequeue_pos_.load(std::memory_order_relaxed);
+      }
+    }
+    read(c->record);
+    c->sequence.store(pos + mask_ + 1, std::memory_order_release);
+    return true;
+  }
+
+private:
+  static constexpr std::size_t preallocated_payload_size{ 256 };
+
+  struct cell {
+    std::atomic<std::size_t> sequence{ 0 };
+    log_record record{};
+  };
+
+  std::unique_ptr<cell[]> cells_{};
+  std::size_t mask_{ 0 };
+  alignas(64) std::atomic<std::size_t> enqueue_pos_{ 0 };
+  alignas(64) std::atomic<std::size_t> dequeue_pos_{ 0 };
+};
+
+void
+append_raw(fmt::memory_buffer& out, std::string_view value)
+{
+  out.append(value.data(), value.data() + value.size());
+}
+
+void
+append_json_string(fmt::memory_buffer& out, std::string_view value)
+{
+  out.push_back('"');
+  for (auto ch : value) {
+    switch (ch) {
+      case '"':
+        append_raw(out, "\\\"");
+        break;
+      case '\\':
+        append_raw(out, "\\\\");
+        break;
+      case '\b':
+        append_raw(out, "\\b");
+        break;
+      case '\f':
+        append_raw(out, "\\f");
+        break;
+      case '\n':
+        append_raw(out, "\\n");
+        break;
+      case '\r':
+        append_raw(out, "\\r");
+        break;
+      case '\t':
+        append_raw(out, "\\t");
+        break;
+      default:
+        if (static_cast<unsigned char>(ch) < 0x20) {
+          fmt::format_to(std::back_inserter(out), "\\u{:04x}", static_cast<unsigned char>(ch));
+        } else {
+          out.push_back(ch);
+        }
+        break;
+    }
+  }
+  out.push_back('"');
+}
+
+/*
+ * Renders the record in the same shape (and key order) as the JSON objects emitted previously:
+ * {"level":...,"message":...,"source":{"file":...,"func":...,"line":...},"thread_id":...,"time":...}
+ */
+void
+format_log_record(fmt::memory_buffer& out, const log_record& record, bool include_source_info)
+{
+  append_raw(out, "{\"level\":");
+  auto level = spdlog::level::to_string_view(record.level);
+  append_json_string(out, { level.data(), level.size() });
+  append_raw(out, ",\"message\":");
+  append_json_string(out, record.payload);
+  if (include_source_info && record.filename != nullptr) {
+    append_raw(out, ",\"source\":{\"file\":");
+    append_json_string(out, record.filename);
+    append_raw(out, ",\"func\":");
+    append_json_string(out, record.funcname == nullptr ? "" : record.funcname);
+    fmt::format_to(std::back_inserter(out), ",\"line\":{}}}", record.line);
+  }
+  fmt::format_to(std::back_inserter(out),
+                 ",\"thread_id\":{},\"time\":\"{:%F %T}.{}\"}}",
+                 record.thread_id,
+                 record.time,
+                 record.time.time_since_epoch().count() % 1'000'000);
+  out.push_back('\0');
+}
+
+auto
+normalize_log_level(std::string level) -> std::string
+{
+  std::transform(level.begin(), level.end(), level.begin(), [](auto c) {
+    return std::tolower(c);
+  });
+  if (level == "fatal" || level == "fatl") {
+    return "critical";
+  }
+  if (level == "trac") {
+    return "trace";
+  }
+  if (level == "debg") {
+    return "debug";
+  }
+  if (level == "eror") {
+    return "error";
+  }
+  return level;
+}
+
+auto
+to_core_log_level(spdlog::level::level_enum level) -> couchbase::core::logger::level
+{
+  switch (level) {
+    case spdlog::level::trace:
+      return couchbase::core::logger::level::trace;
+    case spdlog::level::debug:
+      return couchbase::core::logger::level::debug;
+    case spdlog::level::info:
+      return couchbase::core::logger::level::info;
+    case spdlog::level::warn:
+      return couchbase::core::logger::level::warn;
+    case spdlog::level::err:
+      return couchbase::core::logger::level::err;
+    case spdlog::level::critical:
+      return couchbase::core::logger::level::critical;
+    default:
+      break;
+  }
+  return couchbase::core::logger::level::off;
+}
+
+auto
+trim(std::string_view value) -> std::string_view
+{
+  while (!value.empty() && std::isspace(static_cast<unsigned char>(value.front())) != 0) {
+    value.remove_prefix(1);
+  }
+  while (!value.empty() && std::isspace(static_cast<unsigned char>(value.back())) != 0) {
+    value.remove_suffix(1);
+  }
+  return value;
+}
+
+/*
+ * Parses couchbase.log_categories, the comma-separated list of "{category}={level}" pairs, and returns
+ * the entries that cannot be parsed.
+ */
+auto
+parse_log_categories(std::string_view spec,
+                     std::map<std::string, spdlog::level::level_enum, std::less<>>& levels)
+  -> std::vector<std::string>
+{
+  std::vector<std::string> invalid_entries{};
+  while (!spec.empty()) {
+    auto comma = spec.find(',');
+    auto entry = trim(spec.substr(0, comma));
+    spec = (comma == std::string_view::npos) ? std::string_view{} : spec.substr(comma + 1);
+    if (entry.empty()) {
+      continue;
+    }
+    auto eq = entry.find('=');
+    if (eq == std::string_view::npos) {
+      invalid_entries.emplace_back(entry);
+      continue;
+    }
+    auto category = trim(entry.substr(0, eq));
+    auto level_name = normalize_log_level(std::string{ trim(entry.substr(eq + 1)) });
+    auto level = spdlog::level::from_str(level_name);
+    if (category.empty() || (level == spdlog::level::off && level_name != "off")) {
+      invalid_entries.emplace_back(entry);
+      continue;
+    }
+    levels[std::string{ category }] = level;
+  }
+  return invalid_entries;
+}
+} // namespace
+
+/* what to do with the new message, when the queue of deferred messages is full */
+enum class log_queue_policy {
+  drop_newest,
+  drop_oldest,
+};
+
+class php_log_err_sink : public spdlog::sinks::base_sink<spdlog::details::null_mutex>
 {
 public:
+  /**
+   * Allocates the queue of deferred messages. The capacity is set once, because the producers access
+   * the queue without synchronization.
+   */
+  void reserve(std::size_t capacity, log_queue_policy policy)
+  {
+    std::call_once(reserve_flag_, [this, capacity]() {
+      records_ = std::make_unique<log_record_ring>(capacity);
+    });
+    policy_.store(policy, std::memory_order_relaxed);
+  }
+
+  [[nodiscard]] auto dropped_messages() const -> std::size_t
+  {
+    return total_dropped_.load(std::memory_order_relaxed);
+  }
+
   void flush_deferred_messages()
   {
-    std::lock_guard<Mutex> lock(spdlog::sinks::base_sink<Mutex>::mutex_);
-    auto messages_ = std::move(deferred_messages_);
-    while (!messages_.empty()) {
-      write_message(messages_.front());
-      messages_.pop();
+    if (!records_) {
+      return;
+    }
+    fmt::memory_buffer buffer;
+    auto include_source_info = include_source_info_.load(std::memory_order_relaxed);
+    while (records_->try_pop([&buffer, include_source_info](const log_record& record) {
+      buffer.clear();
+      format_log_record(buffer, record, include_source_info);
+    })) {
+      write_message(buffer.data());
+    }
+    if (auto dropped = dropped_.exchange(0); dropped > 0) {
+      log_record record{};
+      record.level = spdlog::level::warn;
+      record.time = spdlog::log_clock::now();
+      record.thread_id = spdlog::details::os::thread_id();
+      record.payload =
+        fmt::format("{} log message(s) dropped, because the queue of messages is full", dropped);
+      buffer.clear();
+      format_log_record(buffer, record, false);
+      write_message(buffer.data());
     }
   }
 
   void include_source_info(bool include)
   {
-    include_source_info_ = include;
+    include_source_info_.store(include, std::memory_order_relaxed);
   }
 
 protected:
-  struct log_message_for_php {
-    spdlog::level::level_enum level{};
-    spdlog::log_clock::time_point time{};
-    size_t thread_id{};
-    std::string payload{};
-    const char* filename{};
-    int line{};
-    const char* funcname{};
-  };
-
   void sink_it_(const spdlog::details::log_msg& msg) override
   {
-    tao::json::value data = {
-      { "level", fmt::format("{}", spdlog::level::to_string_view(msg.level)) },
-      { "time",
-        fmt::format("{:%F %T}.{}", msg.time, msg.time.time_since_epoch().count() % 1'000'000) },
-      { "message", std::string(msg.payload.data(), msg.payload.size()) },
-      { "thread_id", msg.thread_id },
+    if (!records_) {
+      return;
+    }
+    auto write = [&msg](log_record& record) {
+      record.level = msg.level;
+      record.time = msg.time;
+      record.thread_id = msg.thread_id;
+      record.payload.assign(msg.payload.data(), msg.payload.size());
+      record.filename = msg.source.filename;
+      record.line = msg.source.line;
+      record.funcname = msg.source.funcname;
     };
-    if (include_source_info_ && !msg.source.empty()) {
-      data["source"] = {
-        { "file", msg.source.filename },
-        { "line", msg.source.line },
-        { "func", msg.source.funcname },
-      };
+    if (records_->try_push(write)) {
+      return;
     }
-    deferred_messages_.emplace(std::move(data));
+    if (policy_.load(std::memory_order_relaxed) == log_queue_policy::drop_oldest) {
+      /* make room by discarding the oldest message, the slot might be taken by another producer */
+      while (records_->try_pop([](const log_record& /* record */) {})) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        total_dropped_.fetch_add(1, std::memory_order_relaxed);
+        if (records_->try_push(write)) {
+          return;
+        }
+      }
+    }
+    dropped_.fetch_add(1, std::memory_order_relaxed);
+    total_dropped_.fetch_add(1, std::memory_order_relaxed);
   }
 
   void flush_() override
@@ -94,22 +414,356 @@ protected:
   }
 
 private:
-  void write_message(const tao::json::value& msg)
+  static void write_message(const char* msg)
   {
 #if PHP_VERSION_ID >= 80000
-    php_log_err(core::utils::json::generate(msg).c_str());
+    php_log_err(msg);
 #else
-    auto data = core::utils::json::generate(msg);
-    php_log_err(const_cast<char*>(data.c_str()));
+    php_log_err(const_cast<char*>(msg));
 #endif
   }
 
-  std::queue<tao::json::value> deferred_messages_{};
-  bool include_source_info_{ false };
+  std::once_flag reserve_flag_{};
+  std::unique_ptr<log_record_ring> records_{};
+  std::atomic<std::size_t> dropped_{ 0 };
+  std::atomic<std::size_t> total_dropped_{ 0 };
+  std::atomic<log_queue_policy> policy_{ log_queue_policy::drop_newest };
+  std::atomic_bool include_source_info_{ false };
+};
+
+/**
+ * Sink for couchbase.log_path. The logging threads only copy the message into the queue, while the
+ * dedicated thread formats and writes the messages in batches, and periodically syncs the file to
+ * the disk. So the disk stalls never block the I/O threads of the SDK.
+ */
+class async_file_sink : public spdlog::sinks::base_sink<spdlog::details::null_mutex>
+{
+public:
+  explicit async_file_sink(std::string filename)
+    : filename_{ std::move(filename) }
+  {
+    writer_ = std::thread([this]() {
+      run();
+    });
+  }
+
+  async_file_sink(async_file_sink&& other) = delete;
+  async_file_sink(const async_file_sink& other) = delete;
+  auto operator=(async_file_sink&& other) -> async_file_sink& = delete;
+  auto operator=(const async_file_sink& other) -> async_file_sink& = delete;
+
+  ~async_file_sink() override
+  {
+    stop();
+  }
+
+  /**
+   * Writes remaining messages and stops the writer thread. Must be called before fork(), because
+   * the thread does not exist in the child process.
+   */
+  void stop()
+  {
+    {
+      std::scoped_lock lock(mutex_);
+      if (stopped_) {
+        return;
+      }
+      stopped_ = true;
+    }
+    cv_.notify_one();
+    if (writer_.joinable()) {
+      writer_.join();
+    }
+  }
+
+protected:
+  void sink_it_(const spdlog::details::log_msg& msg) override
+  {
+    bool wake_writer = false;
+    {
+      std::scoped_lock lock(mutex_);
+      if (stopped_) {
+        return;
+      }
+      if (queue_.size() >= max_queued_messages) {
+        ++dropped_;
+        return;
+      }
+      queue_.emplace_back(msg);
+      wake_writer = queue_.size() == batch_size;
+    }
+    if (wake_writer) {
+      cv_.notify_one();
+    }
+  }
+
+  void flush_() override
+  {
+    cv_.notify_one();
+  }
+
+  void set_pattern_(const std::string& pattern) override
+  {
+    set_formatter_(std::make_unique<spdlog::pattern_formatter>(pattern));
+  }
+
+  void set_formatter_(std::unique_ptr<spdlog::formatter> sink_formatter) override
+  {
+    std::scoped_lock lock(mutex_);
+    formatter_ = std::move(sink_formatter);
+    formatter_changed_ = true;
+  }
+
+private:
+  static constexpr std::size_t batch_size{ 512 };
+  static constexpr std::size_t max_queued_messages{ 65536 };
+  static constexpr std::size_t max_file_size{ 100 * 1024 * 1024 };
+  static constexpr std::chrono::seconds sync_interval{ 1 };
+
+  void run()
+  {
+    std::vector<spdlog::details::log_msg_buffer> batch{};
+    std::unique_ptr<spdlog::formatter> formatter{};
+    spdlog::memory_buf_t buffer{};
+    auto last_sync = std::chrono::steady_clock::now();
+    bool stopping = false;
+    while (!stopping) {
+      std::size_t dropped = 0;
+      {
+        std::unique_lock lock(mutex_);
+        cv_.wait_for(lock, sync_interval, [this]() {
+          return stopped_ || queue_.size() >= batch_size;
+        });
+        stopping = stopped_;
+        batch.swap(queue_);
+        dropped = std::exchange(dropped_, 0);
+        if (formatter_changed_) {
+          formatter = formatter_->clone();
+          formatter_changed_ = false;
+        }
+      }
+      for (const auto& msg : batch) {
+        buffer.clear();
+        formatter->format(msg, buffer);
+        write(buffer);
+      }
+      batch.clear();
+      if (dropped > 0) {
+        buffer.clear();
+        fmt::format_to(std::back_inserter(buffer),
+                       "{} log message(s) dropped, because the log file writer does not keep up\n",
+                       dropped);
+        write(buffer);
+      }
+      if (file_ != nullptr) {
+        std::fflush(file_);
+        if (auto now = std::chrono::steady_clock::now();
+            stopping || now - last_sync >= sync_interval) {
+          spdlog::details::os::fsync(file_);
+          last_sync = now;
+        }
+      }
+    }
+    close_file();
+  }
+
+  void write(const spdlog::memory_buf_t& buffer)
+  {
+    if (file_ == nullptr || file_size_ >= max_file_size) {
+      open_next_file();
+    }
+    if (file_ == nullptr) {
+      return;
+    }
+    file_size_ += std::fwrite(buffer.data(), 1, buffer.size(), file_);
+  }
+
+  /* files are named in the same way as the file sink of the core logger: "{filename}.000000.txt" */
+  void open_next_file()
+  {
+    close_file();
+    auto name = fmt::format("{}.{:06}.txt", filename_, file_index_++);
+    file_ = std::fopen(name.c_str(), "ab");
+    if (file_ == nullptr) {
+      return;
+    }
+    std::setvbuf(file_, nullptr, _IOFBF, 64 * 1024);
+    std::fseek(file_, 0, SEEK_END);
+    auto size = std::ftell(file_);
+    file_size_ = size > 0 ? static_cast<std::size_t>(size) : 0;
+  }
+
+  void close_file()
+  {
+    if (file_ != nullptr) {
+      std::fflush(file_);
+      spdlog::details::os::fsync(file_);
+      std::fclose(file_);
+      file_ = nullptr;
+    }
+  }
+
+  const std::string filename_;
+  std::thread writer_{};
+  std::mutex mutex_{};
+  std::condition_variable cv_{};
+  std::vector<spdlog::details::log_msg_buffer> queue_{};
+  std::size_t dropped_{ 0 };
+  bool formatter_changed_{ true };
+  bool stopped_{ false };
+  std::FILE* file_{ nullptr };
+  std::size_t file_size_{ 0 };
+  std::size_t file_index_{ 0 };
+};
+
+/* writer for couchbase.log_path, it is recreated for every initialization of the logger */
+static std::shared_ptr<async_file_sink> global_file_sink{};
+
+/**
+ * Applies couchbase.log_categories and couchbase.log_rate_limit before passing the message to the
+ * actual sinks.
+ *
+ * The category of the message is the name of the directory of its source file, for example "io" for
+ * core/io/mcbp_session.cxx, or "wrapper" for the messages of the extension itself. The rate limit is a
+ * token bucket per call site (file and line), that refills with the given number of messages per
+ * second, and applies to the messages below the warning level.
+ *
+ * The filter does not take locks, so it does not serialize the logging threads in front of the
+ * lock-free queue of php_log_err_sink: the levels of the categories are read-only, and the token
+ * buckets are kept in the fixed table of atomics (the call sites that share the slot of the table
+ * share the bucket).
+ */
+class log_filter_sink : public spdlog::sinks::base_sink<spdlog::details::null_mutex>
+{
+public:
+  log_filter_sink(spdlog::sink_ptr target,
+                  spdlog::level::level_enum default_level,
+                  std::map<std::string, spdlog::level::level_enum, std::less<>> category_levels,
+                  std::size_t rate_limit)
+    : target_{ std::move(target) }
+    , default_level_{ default_level }
+    , category_levels_{ std::move(category_levels) }
+    , rate_limit_{ rate_limit }
+    , emission_interval_{ rate_limit == 0 ? 0
+                                          : static_cast<std::int64_t>(1'000'000'000 / rate_limit) }
+    , call_sites_{ std::make_unique<call_site[]>(call_site_slots) }
+  {
+  }
+
+protected:
+  void sink_it_(const spdlog::details::log_msg& msg) override
+  {
+    if (msg.level < level_for(msg.source.filename)) {
+      return;
+    }
+    if (rate_limit_ == 0 || msg.level >= spdlog::level::warn || msg.source.filename == nullptr) {
+      return target_->log(msg);
+    }
+
+    auto& site = call_sites_[call_site_slot(msg.source.filename, msg.source.line)];
+    if (!take_token(site)) {
+      site.suppressed.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+    auto suppressed = site.suppressed.exchange(0, std::memory_order_relaxed);
+    if (suppressed == 0) {
+      return target_->log(msg);
+    }
+    auto payload = fmt::format("{} (suppressed {} similar message(s))",
+                               std::string_view{ msg.payload.data(), msg.payload.size() },
+                               suppressed);
+    spdlog::details::log_msg annotated{ msg };
+    annotated.payload = { payload.data(), payload.size() };
+    target_->log(annotated);
+  }
+
+  void flush_() override
+  {
+    target_->flush();
+  }
+
+  void set_pattern_(const std::string& pattern) override
+  {
+    target_->set_pattern(pattern);
+  }
+
+  void set_formatter_(std::unique_ptr<spdlog::formatter> sink_formatter) override
+  {
+    target_->set_formatter(std::move(sink_formatter));
+  }
+
+private:
+  static constexpr std::size_t call_site_slots{ 1024 };
+
+  /*
+   * The token bucket in the form of GCRA: instead of the number of tokens, it keeps the time when
+   * the bucket will be full again, so it can be updated with single compare-and-swap.
+   */
+  struct call_site {
+    std::atomic<std::int64_t> full_at{ 0 };
+    std::atomic<std::size_t> suppressed{ 0 };
+  };
+
+  static auto call_site_slot(const char* filename, int line) -> std::size_t
+  {
+    /* the file names are string literals, so the pointer identifies the file */
+    auto hash = reinterpret_cast<std::uintptr_t>(filename) ^
+                (static_cast<std::uintptr_t>(line) * std::uintptr_t{ 0x9e3779b9 });
+    return static_cast<std::size_t>(hash ^ (hash >> 16)) % call_site_slots;
+  }
+
+  auto take_token(call_site& site) const -> bool
+  {
+    auto now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                 std::chrono::steady_clock::now().time_since_epoch())
+                 .count();
+    /* the bucket holds rate_limit_ tokens, so it never takes longer than a second to refill */
+    auto capacity = emission_interval_ * static_cast<std::int64_t>(rate_limit_);
+    auto full_at = site.full_at.load(std::memory_order_relaxed);
+    while (true) {
+      auto next = std::max(full_at, now) + emission_interval_;
+      if (next - now > capacity) {
+        return false;
+      }
+      if (site.full_at.compare_exchange_weak(full_at, next, std::memory_order_relaxed)) {
+        return true;
+      }
+    }
+  }
+
+  auto level_for(const char* filename) const -> spdlog::level::level_enum
+  {
+    if (filename == nullptr || category_levels_.empty()) {
+      return default_level_;
+    }
+    std::string_view path{ filename };
+    if (auto end = path.find_last_of("/\\"); end != std::string_view::npos && end > 0) {
+      auto begin = path.find_last_of("/\\", end - 1);
+      begin = (begin == std::string_view::npos) ? 0 : begin + 1;
+      if (auto it = category_levels_.find(path.substr(begin, end - begin));
+          it != category_levels_.end()) {
+        return it->second;
+      }
+    }
+    return default_level_;
+  }
+
+  spdlog::sink_ptr target_;
+  const spdlog::level::level_enum default_level_;
+  const std::map<std::string, spdlog::level::level_enum, std::less<>> category_levels_;
+  const std::size_t rate_limit_;
+  /* nanoseconds per token */
+  const std::int64_t emission_interval_;
+  std::unique_ptr<call_site[]> call_sites_;
 };
 
-const static std::shared_ptr<php_log_err_sink<std::mutex>> global_php_log_err_sink{
-  std::make_shared<php_log_err_sink<std::mutex>>()
+/* number of messages that can be deferred between the flushes, unless couchbase.log_queue_size set */
+constexpr std::size_t default_log_queue_size{ 4096 };
+/* every slot of the queue preallocates the payload, so the size of the queue is limited */
+constexpr std::size_t max_log_queue_size{ std::size_t{ 1 } << 16 };
+
+const static std::shared_ptr<php_log_err_sink> global_php_log_err_sink{
+  std::make_shared<php_log_err_sink>()
 };
 
 COUCHBASE_API
@@ -121,12 +775,23 @@ flush_logger()
   }
 }
 
+COUCHBASE_API
+auto
+dropped_log_messages() -> std::size_t
+{
+  return global_php_log_err_sink->dropped_messages();
+}
+
 COUCHBASE_API
 void
 shutdown_logger()
 {
   flush_logger();
   couchbase::core::logger::shutdown();
+  if (global_file_sink) {
+    global_file_sink->stop();
+    global_file_sink.reset();
+  }
 }
 
 COUCHBASE_API
@@ -134,50 +799,110 @@ void
 initialize_logger()
 {
   auto spd_log_level = spdlog::level::off;
-  auto cbpp_log_level = couchbase::core::logger::level::off;
   if (auto env_val = spdlog::details::os::getenv("COUCHBASE_LOG_LEVEL"); !env_val.empty()) {
-    cbpp_log_level = couchbase::core::logger::level_from_str(env_val);
     spd_log_level = spdlog::level::from_str(env_val);
   }
   if (const char* ini_val = COUCHBASE_G(log_level); ini_val != nullptr) {
     std::string log_level(ini_val);
     if (!log_level.empty()) {
-      std::transform(log_level.begin(), log_level.end(), log_level.begin(), [](auto c) {
-        return std::tolower(c);
-      });
-      if (log_level == "fatal" || log_level == "fatl") {
-        log_level = "critical";
-      } else if (log_level == "trac") {
-        log_level = "trace";
-      } else if (log_level == "debg") {
-        log_level = "debug";
-      } else if (log_level == "eror") {
-        log_level = "error";
-      }
-      cbpp_log_level = couchbase::core::logger::level_from_str(log_level);
-      spd_log_level = spdlog::level::from_str(log_level);
+      spd_log_level = spdlog::level::from_str(normalize_log_level(log_level));
     }
   }
 
+  std::map<std::string, spdlog::level::level_enum, std::less<>> category_levels{};
+  std::vector<std::string> invalid_categories{};
+  if (const char* ini_val = COUCHBASE_G(log_categories); ini_val != nullptr) {
+    invalid_categories = parse_log_categories(ini_val, category_levels);
+  }
+  std::size_t rate_limit{ 0 };
+  if (COUCHBASE_G(log_rate_limit) > 0) {
+    rate_limit = static_cast<std::size_t>(COUCHBASE_G(log_rate_limit));
+  }
+
+  /* the logger has to pass through the messages of the most verbose category */
+  auto min_log_level = spd_log_level;
+  for (const auto& [category, level] : category_levels) {
+    min_log_level = std::min(min_log_level, level);
+  }
+  auto cbpp_log_level = to_core_log_level(min_log_level);
+  bool filter_messages = !category_levels.empty() || rate_limit > 0;
+  std::string invalid_queue_policy{};
+  bool queue_size_clamped{ false };
+
   if (cbpp_log_level != couchbase::core::logger::level::off) {
     couchbase::core::logger::configuration configuration{};
+    std::vector<spdlog::sink_ptr> sinks{};
+    if (global_file_sink) {
+      global_file_sink->stop();
+      global_file_sink.reset();
+    }
     if (const char* ini_val = COUCHBASE_G(log_path);
         ini_val != nullptr && std::strlen(ini_val) > 0) {
-      configuration.filename = ini_val;
-      configuration.filename += fmt::format(".{}", spdlog::details::os::pid());
+      /* the file is not passed to the core logger, which would write it synchronously */
+      global_file_sink = std::make_shared<async_file_sink>(
+        fmt::format("{}.{}", ini_val, spdlog::details::os::pid()));
+      sinks.emplace_back(global_file_sink);
     }
     configuration.unit_test = true;
-    configuration.console = COUCHBASE_G(log_stderr);
+    if (filter_messages) {
+      /* the console sink of the core logger would bypass the filter */
+      if (COUCHBASE_G(log_stderr)) {
+        sinks.emplace_back(std::make_shared<spdlog::sinks::stderr_color_sink_mt>());
+      }
+    } else {
+      configuration.console = COUCHBASE_G(log_stderr);
+    }
     configuration.log_level = cbpp_log_level;
     if (COUCHBASE_G(log_php_log_err)) {
-      configuration.sink = global_php_log_err_sink;
+      auto queue_size = default_log_queue_size;
+      if (COUCHBASE_G(log_queue_size) > 0) {
+        queue_size = static_cast<std::size_t>(COUCHBASE_G(log_queue_size));
+      }
+      if (queue_size > max_log_queue_size) {
+        queue_size = max_log_queue_size;
+        queue_size_clamped = true;
+      }
+      auto policy = log_queue_policy::drop_newest;
+      if (const char* ini_val = COUCHBASE_G(log_queue_policy); ini_val != nullptr) {
+        if (std::strcmp(ini_val, "drop_oldest") == 0) {
+          policy = log_queue_policy::drop_oldest;
+        } else if (std::strlen(ini_val) > 0 && std::strcmp(ini_val, "drop_newest") != 0) {
+          invalid_queue_policy = ini_val;
+        }
+      }
+      global_php_log_err_sink->reserve(queue_size, policy);
+      sinks.emplace_back(global_php_log_err_sink);
       global_php_log_err_sink->include_source_info(cbpp_log_level ==
                                                    couchbase::core::logger::level::trace);
     }
+    if (sinks.size() == 1) {
+      configuration.sink = sinks.front();
+    } else if (sinks.size() > 1) {
+      configuration.sink =
+        std::make_shared<spdlog::sinks::dist_sink<spdlog::details::null_mutex>>(sinks);
+    }
+    if (filter_messages && configuration.sink) {
+      configuration.sink = std::make_shared<log_filter_sink>(
+        configuration.sink, spd_log_level, std::move(category_levels), rate_limit);
+    }
     couchbase::core::logger::create_file_logger(configuration);
   }
 
-  spdlog::set_level(spd_log_level);
+  spdlog::set_level(min_log_level);
   couchbase::core::logger::set_log_levels(cbpp_log_level);
+
+  for (const auto& entry : invalid_categories) {
+    CB_LOG_WARNING("ignoring invalid entry of couchbase.log_categories: \"{}\"", entry);
+  }
+  if (queue_size_clamped) {
+    CB_LOG_WARNING("couchbase.log_queue_size={} is too large, using {}",
+                   COUCHBASE_G(log_queue_size),
+                   max_log_queue_size);
+  }
+  if (!invalid_queue_policy.empty()) {
+    CB_LOG_WARNING(
+      "ignoring invalid value of couchbase.log_queue_policy: \"{}\", using \"drop_newest\"",
+      invalid_queue_policy);
+  }
 }
 } // namespace couchbase::php
@@ -20,6 +20,8 @@
 
 #include <Zend/zend_API.h>
 
+#include <cstddef>
+
 namespace couchbase::php
 {
 /**
@@ -44,4 +46,12 @@ flush_logger();
 COUCHBASE_API
 void
 shutdown_logger();
+
+/**
+ * Returns number of messages, that have been dropped since the start of the process, because the
+ * queue of the messages deferred for php_log_err() was full (see couchbase.log_queue_size).
+ */
+COUCHBASE_API
+auto
+dropped_log_messages() -> std::size_t;
 } // namespace couchbase::php
@@ -0,0 +1,417 @@
+/**
+ * Copyright 2016-Present Couchbase, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "operation_metrics.hxx"
+
+#include "shared_metrics.hxx"
+
+#include <spdlog/fmt/bundled/format.h>
+
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+#include <string>
+
+namespace couchbase::php
+{
+auto
+latency_histogram::bucket_index(std::uint64_t value) -> std::size_t
+{
+  if (value < sub_bucket_count) {
+    return static_cast<std::size_t>(value);
+  }
+  std::size_t magnitude = 0;
+  for (auto v = value; v > 1; v >>= 1) {
+    ++magnitude;
+  }
+  if (magnitude >= max_magnitude) {
+    return bucket_count - 1;
+  }
+  auto shift = magnitude - sub_bucket_bits;
+  auto sub_bucket = static_cast<std::size_t>(value >> shift) - sub_bucket_count;
+  return (shift + 1) * sub_bucket_count + sub_bucket;
+}
+
+auto
+latency_histogram::highest_equivalent_value(std::size_t index) -> std::uint64_t
+{
+  if (index < sub_bucket_count) {
+    return index;
+  }
+  auto shift = index / sub_bucket_count - 1;
+  auto sub_bucket = index % sub_bucket_count;
+  return ((sub_bucket_count + sub_bucket + 1) << shift) - 1;
+}
+
+void
+latency_histogram::record(std::chrono::microseconds latency)
+{
+  auto value = static_cast<std::uint64_t>(std::max<std::int64_t>(latency.count(), 0));
+  counts_[bucket_index(value)].fetch_add(1, std::memory_order_relaxed);
+  count_.fetch_add(1, std::memory_order_relaxed);
+  sum_.fetch_add(value, std::memory_order_relaxed);
+  auto current_min = min_.load(std::memory_order_relaxed);
+  while (value < current_min &&
+         !min_.compare_exchange_weak(current_min, value, std::memory_order_relaxed)) {
+  }
+  auto current_max = max_.load(std::memory_order_relaxed);
+  while (value > current_max &&
+         !max_.compare_exchange_weak(current_max, value, std::memory_order_relaxed)) {
+  }
+}
+
+auto
+latency_histogram::take_snapshot() const -> snapshot
+{
+  snapshot result{};
+  result.sum = sum_.load(std::memory_order_relaxed);
+  result.max = max_.load(std::memory_order_relaxed);
+  result.min = min_.load(std::memory_order_relaxed);
+  /* the total is computed from the buckets, so that it is consistent with them */
+  for (std::size_t i = 0; i < bucket_count; ++i) {
+    if (auto n = counts_[i].load(std::memory_order_relaxed); n > 0) {
+      result.buckets.emplace_back(highest_equivalent_value(i), n);
+      result.count += n;
+    }
+  }
+  if (result.count == 0) {
+    result.min = 0;
+  }
+  return result;
+}
+
+auto
+latency_histogram::snapshot::value_at_percentile(double percentile) const -> std::uint64_t
+{
+  if (count == 0) {
+    return 0;
+  }
+  auto rank = static_cast<std::uint64_t>(
+    std::ceil(std::clamp(percentile, 0.0, 100.0) / 100.0 * static_cast<double>(count)));
+  rank = std::max<std::uint64_t>(rank, 1);
+  std::uint64_t seen = 0;
+  for (const auto& [value, n] : buckets) {
+    seen += n;
+    if (seen >= rank) {
+      return std::min(value, max);
+    }
+  }
+  return max;
+}
+
+void
+latency_histogram::snapshot::merge(const snapshot& other)
+{
+  if (other.count == 0) {
+    return;
+  }
+  min = (count == 0) ? other.min : std::min(min, other.min);
+  max = std::max(max, other.max);
+  count += other.count;
+  sum += other.sum;
+  std::vector<std::pair<std::uint64_t, std::uint64_t>> merged{};
+  merged.reserve(buckets.size() + other.buckets.size());
+  auto lhs = buckets.begin();
+  auto rhs = other.buckets.begin();
+  while (lhs != buckets.end() || rhs != other.buckets.end()) {
+    if (rhs == other.buckets.end() || (lhs != buckets.end() && lhs->first < rhs->first)) {
+      merged.emplace_back(*lhs++);
+    } else if (lhs == buckets.end() || rhs->first < lhs->first) {
+      merged.emplace_back(*rhs++);
+    } else {
+      merged.emplace_back(lhs->first, lhs->second + rhs->second);
+      ++lhs;
+      ++rhs;
+    }
+  }
+  buckets = std::move(merged);
+}
+
+void
+operation_group::snapshot::merge(const snapshot& other)
+{
+  latency.merge(other.latency);
+  in_flight += other.in_flight;
+  errors += other.errors;
+  timeouts += other.timeouts;
+  retries += other.retries;
+}
+
+void
+operation_group::start()
+{
+  in_flight_.fetch_add(1, std::memory_order_relaxed);
+  if (mirror_ != nullptr) {
+    mirror_->start();
+  }
+}
+
+void
+operation_group::finish(std::chrono::microseconds latency, const operation_outcome& outcome)
+{
+  latency_.record(latency);
+  in_flight_.fetch_sub(1, std::memory_order_relaxed);
+  if (outcome.failed) {
+    errors_.fetch_add(1, std::memory_order_relaxed);
+  }
+  if (outcome.timed_out) {
+    timeouts_.fetch_add(1, std::memory_order_relaxed);
+  }
+  if (outcome.retry_attempts > 0) {
+    retries_.fetch_add(outcome.retry_attempts, std::memory_order_relaxed);
+  }
+  if (mirror_ != nullptr) {
+    mirror_->finish(latency, outcome);
+  }
+}
+
+void
+operation_group::set_mirror(operation_group* mirror)
+{
+  mirror_ = mirror;
+}
+
+void
+operation_group::abandon_in_flight()
+{
+  in_flight_.store(0, std::memory_order_relaxed);
+}
+
+auto
+operation_group::take_snapshot() const -> snapshot
+{
+  snapshot result{};
+  result.latency = latency_.take_snapshot();
+  result.in_flight = in_flight_.load(std::memory_order_relaxed);
+  result.errors = errors_.load(std::memory_order_relaxed);
+  result.timeouts = timeouts_.load(std::memory_order_relaxed);
+  result.retries = retries_.load(std::memory_order_relaxed);
+  return result;
+}
+
+auto
+operation_metrics::group(std::string_view service,
+                         std::string_view operation,
+                         std::string_view bucket) -> operation_group&
+{
+  key_view key{ service, operation, bucket };
+  {
+    std::shared_lock lock(mutex_);
+    if (auto it = groups_.find(key); it != groups_.end()) {
+      return *it->second;
+    }
+  }
+  std::unique_lock lock(mutex_);
+  auto it = groups_.find(key);
+  if (it == groups_.end()) {
+    it = groups_
+           .emplace(operation_metrics_key{ std::string{ service },
+                                           std::string{ operation },
+                                           std::string{ bucket } },
+                    std::make_unique<operation_group>())
+           .first;
+    it->second->set_mirror(shared_operation_group(service, operation, bucket));
+  }
+  return *it->second;
+}
+
+void
+operation_metrics::reattach_mirrors()
+{
+  std::unique_lock lock(mutex_);
+  for (const auto& [key, group] : groups_) {
+    group->set_mirror(shared_operation_group(key.service, key.operation, key.bucket));
+  }
+}
+
+auto
+operation_metrics::take_snapshots() const -> operation_snapshots
+{
+  operation_snapshots snapshots{};
+  std::shared_lock lock(mutex_);
+  snapshots.reserve(groups_.size());
+  for (const auto& [key, group] : groups_) {
+    snapshots.emplace_back(key, group->take_snapshot());
+  }
+  return snapshots;
+}
+
+void
+operation_snapshots_to_zval(zval* return_value, const operation_snapshots& snapshots)
+{
+  array_init_size(return_value, static_cast<uint32_t>(snapshots.size()));
+  for (const auto& [key, group] : snapshots) {
+    const auto& latency = group.latency;
+    zval entry;
+    array_init(&entry);
+    add_assoc_stringl(&entry, "service", key.service.data(), key.service.size());
+    add_assoc_stringl(&entry, "operation", key.operation.data(), key.operation.size());
+    add_assoc_stringl(&entry, "bucket", key.bucket.data(), key.bucket.size());
+    add_assoc_long(&entry, "count", static_cast<zend_long>(latency.count));
+    add_assoc_long(&entry, "inFlight", static_cast<zend_long>(group.in_flight));
+    add_assoc_long(&entry, "errors", static_cast<zend_long>(group.errors));
+    add_assoc_long(&entry, "timeouts", static_cast<zend_long>(group.timeouts));
+    add_assoc_long(&entry, "retries", static_cast<zend_long>(group.retries));
+    add_assoc_long(&entry, "sumUs", static_cast<zend_long>(latency.sum));
+    add_assoc_long(&entry, "minUs", static_cast<zend_long>(latency.min));
+    add_assoc_long(&entry, "maxUs", static_cast<zend_long>(latency.max));
+
+    zval percentiles;
+    array_init(&percentiles);
+    add_assoc_long(&percentiles, "50", static_cast<zend_long>(latency.value_at_percentile(50)));
+    add_assoc_long(&percentiles, "90", static_cast<zend_long>(latency.value_at_percentile(90)));
+    add_assoc_long(&percentiles, "99", static_cast<zend_long>(latency.value_at_percentile(99)));
+    add_assoc_long(
+      &percentiles, "99.9", static_cast<zend_long>(latency.value_at_percentile(99.9)));
+    add_assoc_long(&percentiles, "100", static_cast<zend_long>(latency.max));
+    add_assoc_zval(&entry, "percentilesUs", &percentiles);
+
+    zval buckets;
+    array_init_size(&buckets, static_cast<uint32_t>(latency.buckets.size()));
+    for (const auto& [value, count] : latency.buckets) {
+      zval bucket;
+      array_init_size(&bucket, 2);
+      add_next_index_long(&bucket, static_cast<zend_long>(value));
+      add_next_index_long(&bucket, static_cast<zend_long>(count));
+      add_next_index_zval(&buckets, &bucket);
+    }
+    add_assoc_zval(&entry, "bucketsUs", &buckets);
+
+    add_next_index_zval(return_value, &entry);
+  }
+}
+
+namespace
+{
+/* boundaries of the exported latency histogram, and their canonical representation in seconds */
+constexpr std::array<std::pair<std::uint64_t, std::string_view>, 16> open_metrics_latency_bounds{ {
+  { 100, "0.0001" },
+  { 250, "0.00025" },
+  { 500, "0.0005" },
+  { 1'000, "0.001" },
+  { 2'500, "0.0025" },
+  { 5'000, "0.005" },
+  { 10'000, "0.01" },
+  { 25'000, "0.025" },
+  { 50'000, "0.05" },
+  { 100'000, "0.1" },
+  { 250'000, "0.25" },
+  { 500'000, "0.5" },
+  { 1'000'000, "1.0" },
+  { 2'500'000, "2.5" },
+  { 5'000'000, "5.0" },
+  { 10'000'000, "10.0" },
+} };
+
+void
+append_group_labels(std::string& out, const operation_metrics_key& key)
+{
+  out += "service=\"";
+  append_open_metrics_label_value(out, key.service);
+  out += "\",operation=\"";
+  append_open_metrics_label_value(out, key.operation);
+  out += "\",bucket=\"";
+  append_open_metrics_label_value(out, key.bucket);
+  out += '"';
+}
+} // namespace
+
+void
+append_open_metrics_label_value(std::string& out, std::string_view value)
+{
+  for (auto ch : value) {
+    switch (ch) {
+      case '\\':
+        out += "\\\\";
+        break;
+      case '"':
+        out += "\\\"";
+        break;
+      case '\n':
+        out += "\\n";
+        break;
+      default:
+        out += ch;
+        break;
+    }
+  }
+}
+
+void
+append_open_metrics(std::string& out, const operation_snapshots& snapshots)
+{
+  out += "# TYPE couchbase_operation_duration_seconds histogram\n"
+         "# UNIT couchbase_operation_duration_seconds seconds\n"
+         "# HELP couchbase_operation_duration_seconds Latency of the operations.\n";
+  for (const auto& [key, group] : snapshots) {
+    const auto& latency = group.latency;
+    auto it = latency.buckets.begin();
+    std::uint64_t cumulative = 0;
+    for (const auto& [bound, bound_name] : open_metrics_latency_bounds) {
+      for (; it != latency.buckets.end() && it->first <= bound; ++it) {
+        cumulative += it->second;
+      }
+      out += "couchbase_operation_duration_seconds_bucket{";
+      append_group_labels(out, key);
+      out += fmt::format(",le=\"{}\"}} {}\n", bound_name, cumulative);
+    }
+    out += "couchbase_operation_duration_seconds_bucket{";
+    append_group_labels(out, key);
+    out += fmt::format(",le=\"+Inf\"}} {}\n", latency.count);
+    out += "couchbase_operation_duration_seconds_count{";
+    append_group_labels(out, key);
+    out += fmt::format("}} {}\n", latency.count);
+    out += "couchbase_operation_duration_seconds_sum{";
+    append_group_labels(out, key);
+    out += fmt::format("}} {}\n", static_cast<double>(latency.sum) / 1e6);
+  }
+
+  auto append_family = [&out, &snapshots](std::string_view name,
+                                          std::string_view type,
+                                          std::string_view help,
+                                          std::string_view suffix,
+                                          const auto& value) {
+    out += fmt::format("# TYPE {0} {1}\n# HELP {0} {2}\n", name, type, help);
+    for (const auto& [key, group] : snapshots) {
+      out += name;
+      out += suffix;
+      out += '{';
+      append_group_labels(out, key);
+      out += fmt::format("}} {}\n", value(group));
+    }
+  };
+  append_family("couchbase_operations_in_flight",
+                "gauge",
+                "Number of the operations in flight.",
+                "",
+                [](const operation_group::snapshot& group) { return group.in_flight; });
+  append_family("couchbase_operation_errors",
+                "counter",
+                "Number of the failed operations.",
+                "_total",
+                [](const operation_group::snapshot& group) { return group.errors; });
+  append_family("couchbase_operation_timeouts",
+                "counter",
+                "Number of the operations that timed out.",
+                "_total",
+                [](const operation_group::snapshot& group) { return group.timeouts; });
+  append_family("couchbase_operation_retries",
+                "counter",
+                "Number of the retry attempts.",
+                "_total",
+                [](const operation_group::snapshot& group) { return group.retries; });
+}
+} // namespace couchbase::php
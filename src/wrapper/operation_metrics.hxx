@@ -0,0 +1,196 @@
+/**
+ * Copyright 2016-Present Couchbase, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <Zend/zend_API.h>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace couchbase::php
+{
+/**
+ * Log-linear histogram of latencies in microseconds (in the spirit of HdrHistogram). Every power of
+ * two is split into 32 linear sub-buckets, so the recorded value is off by less than 3.2%, and the
+ * range covers up to 2^40 microseconds. Recording is wait-free, so the histogram can be updated
+ * directly from the I/O threads.
+ */
+class latency_histogram
+{
+public:
+  static constexpr std::size_t sub_bucket_bits{ 5 };
+  static constexpr std::size_t sub_bucket_count{ std::size_t{ 1 } << sub_bucket_bits };
+  static constexpr std::size_t max_magnitude{ 40 };
+  static constexpr std::size_t bucket_count{ (max_magnitude - sub_bucket_bits + 1) *
+                                             sub_bucket_count };
+
+  struct snapshot {
+    std::uint64_t count{ 0 };
+    std::uint64_t sum{ 0 };
+    std::uint64_t min{ 0 };
+    std::uint64_t max{ 0 };
+    /* pairs of the highest value of the bucket and the number of values recorded into it */
+    std::vector<std::pair<std::uint64_t, std::uint64_t>> buckets{};
+
+    [[nodiscard]] auto value_at_percentile(double percentile) const -> std::uint64_t;
+
+    void merge(const snapshot& other);
+  };
+
+  void record(std::chrono::microseconds latency);
+
+  [[nodiscard]] auto take_snapshot() const -> snapshot;
+
+  static auto bucket_index(std::uint64_t value) -> std::size_t;
+  static auto highest_equivalent_value(std::size_t index) -> std::uint64_t;
+
+private:
+  std::array<std::atomic<std::uint64_t>, bucket_count> counts_{};
+  std::atomic<std::uint64_t> count_{ 0 };
+  std::atomic<std::uint64_t> sum_{ 0 };
+  std::atomic<std::uint64_t> min_{ UINT64_MAX };
+  std::atomic<std::uint64_t> max_{ 0 };
+};
+
+struct operation_outcome {
+  bool failed{ false };
+  bool timed_out{ false };
+  std::size_t retry_attempts{ 0 };
+};
+
+/**
+ * Statistics of one group of the operations: latency histogram, number of the operations in flight,
+ * and counters of errors, timeouts and retries.
+ */
+class operation_group
+{
+public:
+  struct snapshot {
+    latency_histogram::snapshot latency{};
+    std::int64_t in_flight{ 0 };
+    std::uint64_t errors{ 0 };
+    std::uint64_t timeouts{ 0 };
+    std::uint64_t retries{ 0 };
+
+    void merge(const snapshot& other);
+  };
+
+  void start();
+
+  void finish(std::chrono::microseconds latency, const operation_outcome& outcome);
+
+  [[nodiscard]] auto take_snapshot() const -> snapshot;
+
+  /**
+   * Every update of this group will be also applied to the mirror (e.g. the copy of the group in
+   * the shared memory segment).
+   */
+  void set_mirror(operation_group* mirror);
+
+  /**
+   * Forgets the operations in flight, used when the group of the exited process is adopted.
+   */
+  void abandon_in_flight();
+
+private:
+  operation_group* mirror_{ nullptr };
+  latency_histogram latency_{};
+  std::atomic<std::int64_t> in_flight_{ 0 };
+  std::atomic<std::uint64_t> errors_{ 0 };
+  std::atomic<std::uint64_t> timeouts_{ 0 };
+  std::atomic<std::uint64_t> retries_{ 0 };
+};
+
+struct operation_metrics_key {
+  std::string service{};
+  std::string operation{};
+  std::string bucket{};
+};
+
+using operation_snapshots = std::vector<std::pair<operation_metrics_key, operation_group::snapshot>>;
+
+struct operation_metrics_key_less {
+  using is_transparent = void;
+
+  template<typename L, typename R>
+  auto operator()(const L& lhs, const R& rhs) const -> bool
+  {
+    return std::tie(lhs.service, lhs.operation, lhs.bucket) <
+           std::tie(rhs.service, rhs.operation, rhs.bucket);
+  }
+};
+
+/**
+ * Statistics of the operations executed through the connection, grouped by service, operation and
+ * bucket. The groups are created on the first use, and never removed (so the references stay valid),
+ * and the number of the groups is bounded by the set of operations the application uses.
+ */
+class operation_metrics
+{
+public:
+  auto group(std::string_view service, std::string_view operation, std::string_view bucket)
+    -> operation_group&;
+
+  /**
+   * Returns snapshots of all groups, ordered by service, operation and bucket.
+   */
+  [[nodiscard]] auto take_snapshots() const -> operation_snapshots;
+
+  /**
+   * Points the groups to the slot of the current process. Called in the child after fork(), because
+   * the mirrors inherited from the parent still write into the slot of the parent.
+   */
+  void reattach_mirrors();
+
+private:
+  struct key_view {
+    std::string_view service;
+    std::string_view operation;
+    std::string_view bucket;
+  };
+
+  mutable std::shared_mutex mutex_{};
+  std::map<operation_metrics_key, std::unique_ptr<operation_group>, operation_metrics_key_less>
+    groups_{};
+};
+
+void
+operation_snapshots_to_zval(zval* return_value, const operation_snapshots& snapshots);
+
+/**
+ * Appends the metric families of the groups in OpenMetrics text format. The latency histogram is
+ * exposed with the fixed set of boundaries.
+ */
+void
+append_open_metrics(std::string& out, const operation_snapshots& snapshots);
+
+/**
+ * Appends the value of the label, escaping it as required by OpenMetrics text format.
+ */
+void
+append_open_metrics_label_value(std::string& out, std::string_view value);
+} // namespace couchbase::php
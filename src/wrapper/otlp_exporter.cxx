@@ -0,0 +1,640 @@
+/**
+ * Copyright 2016-Present Couchbase, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "otlp_exporter.hxx"
+
+#include "../php_couchbase.hxx"
+#include "common.hxx"
+
+#include <core/logger/logger.hxx>
+#include <core/tracing/wrapper_sdk_tracer.hxx>
+#include <core/utils/json.hxx>
+
+#include <spdlog/fmt/bundled/core.h>
+
+#include <tao/json/value.hpp>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/file.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace couchbase::php
+{
+namespace
+{
+constexpr std::string_view file_scheme{ "file://" };
+constexpr std::string_view unix_scheme{ "unix://" };
+
+/* values of the SpanKind and StatusCode enums of OTLP */
+constexpr int span_kind_internal{ 1 };
+constexpr int span_kind_client{ 3 };
+constexpr int status_code_error{ 2 };
+
+/*
+ * Incremented in the child process after every fork(). The exporter compares it with the value
+ * remembered when its implementation was created, to notice that it has been inherited from the
+ * parent process.
+ */
+std::atomic<std::uint64_t> fork_generation{ 0 };
+
+#ifndef _WIN32
+std::once_flag fork_handler_registered{};
+
+void
+on_fork_child()
+{
+  fork_generation.fetch_add(1, std::memory_order_relaxed);
+}
+#endif
+
+auto
+to_unix_nano(std::chrono::system_clock::time_point time) -> std::string
+{
+  return std::to_string(
+    std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count());
+}
+
+auto
+string_attribute(std::string key, std::string value) -> tao::json::value
+{
+  return {
+    { "key", std::move(key) },
+    { "value", { { "stringValue", std::move(value) } } },
+  };
+}
+
+auto
+int_attribute(std::string key, std::uint64_t value) -> tao::json::value
+{
+  /* 64-bit integers are encoded as strings in OTLP/JSON */
+  return {
+    { "key", std::move(key) },
+    { "value", { { "intValue", std::to_string(value) } } },
+  };
+}
+
+class span_id_generator
+{
+public:
+  auto trace_id() -> std::string
+  {
+    return fmt::format("{:016x}{:016x}", random_(), random_());
+  }
+
+  auto span_id() -> std::string
+  {
+    return fmt::format("{:016x}", random_());
+  }
+
+private:
+  std::mt19937_64 random_{ std::random_device{}() };
+};
+
+/* converts the operation into the list of the spans, the operation itself becomes the root span */
+void
+append_operation_spans(std::vector<tao::json::value>& spans,
+                       const otlp_operation& operation,
+                       span_id_generator& ids)
+{
+  auto trace_id = ids.trace_id();
+  auto root_id = ids.span_id();
+
+  tao::json::value attributes = tao::json::empty_array;
+  attributes.get_array().emplace_back(string_attribute("db.system.name", "couchbase"));
+  attributes.get_array().emplace_back(
+    string_attribute("couchbase.service", std::string{ operation.service }));
+  if (!operation.bucket.empty()) {
+    attributes.get_array().emplace_back(string_attribute("db.namespace", operation.bucket));
+  }
+  tao::json::value root = {
+    { "traceId", trace_id },
+    { "spanId", root_id },
+    { "name", std::string{ operation.operation } },
+    { "kind", span_kind_client },
+    { "startTimeUnixNano", to_unix_nano(operation.start_time) },
+    { "endTimeUnixNano", to_unix_nano(operation.end_time) },
+    { "attributes", std::move(attributes) },
+  };
+  if (operation.ec) {
+    root.get_object().emplace("status",
+                              tao::json::value{
+                                { "code", status_code_error },
+                                { "message", operation.ec.message() },
+                              });
+  }
+  spans.emplace_back(std::move(root));
+
+  if (!operation.spans) {
+    return;
+  }
+  std::vector<std::pair<std::shared_ptr<core::tracing::wrapper_sdk_span>, std::string>> pending{};
+  for (auto& child : operation.spans->children()) {
+    pending.emplace_back(std::move(child), root_id);
+  }
+  while (!pending.empty()) {
+    auto [span, parent_id] = std::move(pending.back());
+    pending.pop_back();
+
+    auto span_id = ids.span_id();
+    tao::json::value span_attributes = tao::json::empty_array;
+    for (const auto& [key, value] : span->uint_tags()) {
+      span_attributes.get_array().emplace_back(int_attribute(key, value));
+    }
+    for (const auto& [key, value] : span->string_tags()) {
+      span_attributes.get_array().emplace_back(string_attribute(key, value));
+    }
+    spans.emplace_back(tao::json::value{
+      { "traceId", trace_id },
+      { "spanId", span_id },
+      { "parentSpanId", std::move(parent_id) },
+      { "name", span->name() },
+      { "kind", span->name() == "dispatch_to_server" ? span_kind_client : span_kind_internal },
+      { "startTimeUnixNano", to_unix_nano(span->start_time()) },
+      { "endTimeUnixNano", to_unix_nano(span->end_time()) },
+      { "attributes", std::move(span_attributes) },
+    });
+
+    for (auto& child : span->children()) {
+      pending.emplace_back(std::move(child), span_id);
+    }
+  }
+}
+
+auto
+encode_batch(const std::vector<otlp_operation>& batch,
+             const std::string& service_name,
+             span_id_generator& ids) -> std::string
+{
+  tao::json::value spans = tao::json::empty_array;
+  for (const auto& operation : batch) {
+    append_operation_spans(spans.get_array(), operation, ids);
+  }
+  tao::json::value resource_attributes = tao::json::empty_array;
+  resource_attributes.get_array().emplace_back(string_attribute("service.name", service_name));
+  resource_attributes.get_array().emplace_back(
+    string_attribute("telemetry.sdk.name", "couchbase-php-client"));
+  resource_attributes.get_array().emplace_back(
+    string_attribute("telemetry.sdk.version", PHP_COUCHBASE_VERSION));
+  tao::json::value scope_spans = tao::json::empty_array;
+  scope_spans.get_array().emplace_back(tao::json::value{
+    { "scope", { { "name", "couchbase-php-client" }, { "version", PHP_COUCHBASE_VERSION } } },
+    { "spans", std::move(spans) },
+  });
+  tao::json::value resource_spans = tao::json::empty_array;
+  resource_spans.get_array().emplace_back(tao::json::value{
+    { "resource", { { "attributes", std::move(resource_attributes) } } },
+    { "scopeSpans", std::move(scope_spans) },
+  });
+  return core::utils::json::generate(tao::json::value{
+    { "resourceSpans", std::move(resource_spans) },
+  });
+}
+} // namespace
+
+class otlp_exporter::impl
+{
+public:
+  impl(std::string endpoint, std::string service_name, std::size_t queue_size)
+    : endpoint_{ std::move(endpoint) }
+    , service_name_{ std::move(service_name) }
+    , queue_size_{ queue_size }
+  {
+  }
+
+  impl(impl&& other) = delete;
+  impl(const impl& other) = delete;
+  auto operator=(impl&& other) -> impl& = delete;
+  auto operator=(const impl& other) -> impl& = delete;
+
+  ~impl()
+  {
+    stop();
+#ifdef _WIN32
+    if (file_ != nullptr) {
+      std::fclose(file_);
+    }
+#else
+    if (file_ != -1) {
+      close(file_);
+    }
+#endif
+  }
+
+  void submit(otlp_operation&& operation)
+  {
+    bool wake_writer = false;
+    {
+      std::scoped_lock lock(mutex_);
+      if (!running_) {
+        return;
+      }
+      if (queue_.size() >= queue_size_) {
+        ++dropped_;
+        return;
+      }
+      queue_.emplace_back(std::move(operation));
+      wake_writer = queue_.size() == batch_size;
+    }
+    if (wake_writer) {
+      cv_.notify_one();
+    }
+  }
+
+  void start()
+  {
+    std::scoped_lock lock(mutex_);
+    if (running_) {
+      return;
+    }
+    running_ = true;
+    writer_ = std::thread([this]() {
+      run();
+    });
+  }
+
+  void stop()
+  {
+    {
+      std::scoped_lock lock(mutex_);
+      if (!running_) {
+        return;
+      }
+      running_ = false;
+    }
+    cv_.notify_one();
+    if (writer_.joinable()) {
+      writer_.join();
+    }
+  }
+
+  /*
+   * Called in the child process instead of the destructor, when the object has been inherited
+   * while the thread was running. The thread does not exist anymore, and it might have held mutex_
+   * or been modifying queue_ at the moment of fork(), so neither of them is touched, and the object
+   * is leaked. Only the descriptor of the file is closed.
+   */
+  void abandon()
+  {
+#ifndef _WIN32
+    if (file_ != -1) {
+      close(file_);
+      file_ = -1;
+    }
+#endif
+  }
+
+private:
+  static constexpr std::size_t batch_size{ 512 };
+  static constexpr std::chrono::seconds export_interval{ 1 };
+
+  void run()
+  {
+    span_id_generator ids{};
+    std::vector<otlp_operation> batch{};
+    bool stopping = false;
+    while (!stopping) {
+      std::size_t dropped = 0;
+      {
+        std::unique_lock lock(mutex_);
+        cv_.wait_for(lock, export_interval, [this]() {
+          return !running_ || queue_.size() >= batch_size;
+        });
+        stopping = !running_;
+        /* on stop, the remaining operations are exported in one batch */
+        auto count = stopping ? queue_.size() : std::min(queue_.size(), batch_size);
+        batch.assign(std::make_move_iterator(queue_.begin()),
+                     std::make_move_iterator(queue_.begin() + static_cast<std::ptrdiff_t>(count)));
+        queue_.erase(queue_.begin(), queue_.begin() + static_cast<std::ptrdiff_t>(count));
+        dropped = std::exchange(dropped_, 0);
+      }
+      if (dropped > 0) {
+        CB_LOG_WARNING("{} operation(s) dropped, because the OTLP exporter does not keep up",
+                       dropped);
+      }
+      if (batch.empty()) {
+        continue;
+      }
+      auto payload = encode_batch(batch, service_name_, ids);
+      batch.clear();
+      auto error = send(std::move(payload));
+      if (!error.empty() && !failing_) {
+        CB_LOG_WARNING("unable to export spans to \"{}\": {}", endpoint_, error);
+      } else if (error.empty() && failing_) {
+        CB_LOG_INFO("export of spans to \"{}\" has been resumed", endpoint_);
+      }
+      failing_ = !error.empty();
+    }
+  }
+
+  /* returns the description of the error, or empty string on success */
+  auto send(std::string payload) -> std::string
+  {
+    if (endpoint_.rfind(file_scheme, 0) == 0) {
+      payload += '\n';
+      return append_to_file(endpoint_.substr(file_scheme.size()), payload);
+    }
+    return post_to_unix_socket(endpoint_.substr(unix_scheme.size()), payload);
+  }
+
+#ifdef _WIN32
+  auto append_to_file(const std::string& path, const std::string& line) -> std::string
+  {
+    if (file_ == nullptr) {
+      file_ = std::fopen(path.c_str(), "ab");
+      if (file_ == nullptr) {
+        return std::strerror(errno);
+      }
+    }
+    std::fwrite(line.data(), 1, line.size(), file_);
+    if (std::fflush(file_) != 0) {
+      auto error = std::strerror(errno);
+      std::fclose(file_);
+      file_ = nullptr;
+      return error;
+    }
+    return {};
+  }
+#else
+  /*
+   * Many processes (e.g. the workers of PHP-FPM) might append to the same file, so every line is
+   * written directly to the descriptor opened with O_APPEND, while holding the exclusive lock of
+   * the file. The lock is associated with the open file description, so the child process opens
+   * the file again (in its own implementation object) instead of using the inherited descriptor.
+   */
+  auto append_to_file(const std::string& path, const std::string& line) -> std::string
+  {
+    if (file_ == -1) {
+      file_ = open(path.c_str(), O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, 0644);
+      if (file_ == -1) {
+        return std::strerror(errno);
+      }
+    }
+    if (flock(file_, LOCK_EX) == -1) {
+      return std::strerror(errno);
+    }
+    std::string error{};
+    std::size_t written = 0;
+    while (written < line.size()) {
+      auto n = write(file_, line.data() + written, line.size() - written);
+      if (n == -1 && errno == EINTR) {
+        continue;
+      }
+      if (n == -1) {
+        error = std::strerror(errno);
+        break;
+      }
+      written += static_cast<std::size_t>(n);
+    }
+    flock(file_, LOCK_UN);
+    if (!error.empty()) {
+      close(file_);
+      file_ = -1;
+    }
+    return error;
+  }
+#endif
+
+  static auto post_to_unix_socket(const std::string& path, const std::string& payload)
+    -> std::string
+  {
+#ifdef _WIN32
+    (void)path;
+    (void)payload;
+    return "Unix sockets are not supported on this platform";
+#else
+    sockaddr_un address{};
+    if (path.size() >= sizeof(address.sun_path)) {
+      return "the path of the socket is too long";
+    }
+    address.sun_family = AF_UNIX;
+    std::memcpy(address.sun_path, path.data(), path.size());
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd == -1) {
+      return std::strerror(errno);
+    }
+    timeval timeout{ 5, 0 };
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    if (connect(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) == -1) {
+      auto error = std::strerror(errno);
+      close(fd);
+      return error;
+    }
+
+    auto request = fmt::format("POST /v1/traces HTTP/1.1\r\n"
+                               "Host: localhost\r\n"
+                               "Content-Type: application/json\r\n"
+                               "Content-Length: {}\r\n"
+                               "Connection: close\r\n"
+                               "\r\n",
+                               payload.size());
+    request.append(payload);
+    std::size_t sent = 0;
+    while (sent < request.size()) {
+      auto n = ::send(fd, request.data() + sent, request.size() - sent, MSG_NOSIGNAL);
+      if (n <= 0) {
+        auto error = std::strerror(errno);
+        close(fd);
+        return error;
+      }
+      sent += static_cast<std::size_t>(n);
+    }
+
+    /* only the status line is interesting, e.g. "HTTP/1.1 200 OK" */
+    std::array<char, 64> status{};
+    auto n = recv(fd, status.data(), status.size() - 1, 0);
+    close(fd);
+    if (n <= 0) {
+      return "collector closed the connection without response";
+    }
+    std::string_view status_line{ status.data(), static_cast<std::size_t>(n) };
+    if (auto space = status_line.find(' ');
+        space == std::string_view::npos || status_line.substr(space + 1, 1) != "2") {
+      return fmt::format("unexpected response from collector: \"{}\"",
+                         status_line.substr(0, status_line.find('\r')));
+    }
+    return {};
+#endif
+  }
+
+  const std::string endpoint_;
+  const std::string service_name_;
+  const std::size_t queue_size_;
+  std::thread writer_{};
+  std::mutex mutex_{};
+  std::condition_variable cv_{};
+  std::vector<otlp_operation> queue_{};
+  std::size_t dropped_{ 0 };
+  bool running_{ false };
+  bool failing_{ false };
+#ifdef _WIN32
+  std::FILE* file_{ nullptr };
+#else
+  int file_{ -1 };
+#endif
+};
+
+otlp_exporter::otlp_exporter(std::string endpoint, std::string service_name, std::size_t queue_size)
+  : endpoint_{ std::move(endpoint) }
+  , service_name_{ std::move(service_name) }
+  , queue_size_{ queue_size }
+  , impl_{ std::make_shared<impl>(endpoint_, service_name_, queue_size_) }
+  , generation_{ fork_generation.load(std::memory_order_acquire) }
+{
+#ifndef _WIN32
+  std::call_once(fork_handler_registered, []() {
+    pthread_atfork(nullptr, nullptr, on_fork_child);
+  });
+#endif
+}
+
+otlp_exporter::~otlp_exporter()
+{
+  stop();
+}
+
+void
+otlp_exporter::submit(otlp_operation&& operation)
+{
+  current()->submit(std::move(operation));
+}
+
+void
+otlp_exporter::start()
+{
+  auto current_impl = current();
+  started_ = true;
+  current_impl->start();
+}
+
+void
+otlp_exporter::stop()
+{
+  auto current_impl = current();
+  started_ = false;
+  current_impl->stop();
+}
+
+/*
+ * The child process does not touch the implementation inherited from the parent, unless it was
+ * stopped before fork() (with Cluster::notifyFork() or the fork handlers), and creates new one.
+ * Otherwise, the mutex of the inherited object might be locked forever by the thread, which does
+ * not exist in the child.
+ */
+auto
+otlp_exporter::current() -> std::shared_ptr<impl>
+{
+  auto generation = fork_generation.load(std::memory_order_acquire);
+  if (generation_.load(std::memory_order_acquire) == generation) {
+    return std::atomic_load(&impl_);
+  }
+  std::scoped_lock lock(fork_mutex_);
+  if (generation_.load(std::memory_order_acquire) == generation) {
+    return std::atomic_load(&impl_);
+  }
+  auto inherited = std::atomic_load(&impl_);
+  auto fresh = std::make_shared<impl>(endpoint_, service_name_, queue_size_);
+  if (started_) {
+    inherited->abandon();
+    static_cast<void>(new std::shared_ptr<impl>(std::move(inherited)));
+    fresh->start();
+  }
+  std::atomic_store(&impl_, fresh);
+  generation_.store(generation, std::memory_order_release);
+  return fresh;
+}
+
+namespace
+{
+std::mutex global_exporter_mutex{};
+std::shared_ptr<otlp_exporter> global_exporter{};
+} // namespace
+
+COUCHBASE_API
+void
+initialize_otlp_exporter()
+{
+  std::scoped_lock lock(global_exporter_mutex);
+  if (global_exporter) {
+    return;
+  }
+  const char* endpoint = COUCHBASE_G(otlp_endpoint);
+  if (endpoint == nullptr || endpoint[0] == '\0') {
+    return;
+  }
+  std::string_view endpoint_view{ endpoint };
+  if (endpoint_view.rfind(file_scheme, 0) != 0 && endpoint_view.rfind(unix_scheme, 0) != 0) {
+    CB_LOG_WARNING("couchbase.otlp_endpoint must start with \"{}\" or \"{}\", \"{}\" given, spans "
+                   "will not be exported",
+                   file_scheme,
+                   unix_scheme,
+                   endpoint);
+    return;
+  }
+  std::string service_name{ "php" };
+  if (const char* ini_val = COUCHBASE_G(otlp_service_name); ini_val != nullptr && ini_val[0]) {
+    service_name = ini_val;
+  }
+  std::size_t queue_size{ 2048 };
+  if (COUCHBASE_G(otlp_queue_size) > 0) {
+    queue_size = static_cast<std::size_t>(COUCHBASE_G(otlp_queue_size));
+  }
+  global_exporter = std::make_shared<otlp_exporter>(endpoint, service_name, queue_size);
+  global_exporter->start();
+}
+
+COUCHBASE_API
+void
+shutdown_otlp_exporter()
+{
+  std::shared_ptr<otlp_exporter> exporter{};
+  {
+    std::scoped_lock lock(global_exporter_mutex);
+    exporter = std::move(global_exporter);
+  }
+  if (exporter) {
+    exporter->stop();
+  }
+}
+
+COUCHBASE_API
+auto
+current_otlp_exporter() -> std::shared_ptr<otlp_exporter>
+{
+  std::scoped_lock lock(global_exporter_mutex);
+  return global_exporter;
+}
+} // namespace couchbase::php
@@ -0,0 +1,122 @@
+/**
+ * Copyright 2016-Present Couchbase, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "api_visibility.hxx"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <system_error>
+
+namespace couchbase::core::tracing
+{
+class wrapper_sdk_span;
+} // namespace couchbase::core::tracing
+
+namespace couchbase::php
+{
+/**
+ * Operation with the tree of the spans recorded by the core, ready to be exported.
+ */
+struct otlp_operation {
+  std::string_view service{};
+  std::string_view operation{};
+  std::string bucket{};
+  std::chrono::system_clock::time_point start_time{};
+  std::chrono::system_clock::time_point end_time{};
+  std::error_code ec{};
+  std::shared_ptr<couchbase::core::tracing::wrapper_sdk_span> spans{};
+};
+
+/**
+ * Exports the spans of the operations in OTLP/JSON format from the background thread, so that
+ * tracing does not cost any PHP code per span.
+ *
+ * Supported endpoints:
+ *
+ * * "file:///path/to/traces.jsonl" - every batch is appended as one line of the file (the format
+ *   of the "otlpjsonfile" receiver of OpenTelemetry Collector), the lines of the processes writing
+ *   into the same file do not interleave
+ * * "unix:///path/to/collector.sock" - every batch is sent as HTTP POST /v1/traces request to the
+ *   OTLP/HTTP receiver listening on the Unix socket
+ */
+class otlp_exporter
+{
+public:
+  otlp_exporter(std::string endpoint, std::string service_name, std::size_t queue_size);
+
+  otlp_exporter(otlp_exporter&& other) = delete;
+  otlp_exporter(const otlp_exporter& other) = delete;
+  auto operator=(otlp_exporter&& other) -> otlp_exporter& = delete;
+  auto operator=(const otlp_exporter& other) -> otlp_exporter& = delete;
+
+  ~otlp_exporter();
+
+  /**
+   * Queues the operation for the export, the operation is dropped if the queue is full.
+   */
+  void submit(otlp_operation&& operation);
+
+  /**
+   * Starts the background thread.
+   */
+  void start();
+
+  /**
+   * Exports queued operations and stops the background thread. Should be called before fork(),
+   * because the thread does not exist in the child process (otherwise the child leaks the state
+   * inherited from the parent with the queued operations, and starts its own thread).
+   */
+  void stop();
+
+private:
+  class impl;
+
+  auto current() -> std::shared_ptr<impl>;
+
+  const std::string endpoint_;
+  const std::string service_name_;
+  const std::size_t queue_size_;
+  std::shared_ptr<impl> impl_;
+  std::atomic<std::uint64_t> generation_;
+  std::atomic_bool started_{ false };
+  std::mutex fork_mutex_{};
+};
+
+/**
+ * Creates the exporter configured with couchbase.otlp_endpoint (does nothing when it is empty).
+ */
+COUCHBASE_API
+void
+initialize_otlp_exporter();
+
+COUCHBASE_API
+void
+shutdown_otlp_exporter();
+
+/**
+ * Returns the exporter of the process, or nullptr if the export is not configured.
+ */
+COUCHBASE_API
+auto
+current_otlp_exporter() -> std::shared_ptr<otlp_exporter>;
+} // namespace couchbase::php
@@ -0,0 +1,459 @@
+/**
+ * Copyright 2016-Present Couchbase, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "partition_range_scan.hxx"
+
+#include <core/collections_options.hxx>
+#include <core/logger/logger.hxx>
+
+#include <couchbase/error_codes.hxx>
+
+#include <algorithm>
+#include <utility>
+
+namespace couchbase::php
+{
+namespace
+{
+/* number of times the stream of one vBucket is created again after retryable errors */
+constexpr std::size_t max_stream_retries{ 5 };
+
+/*
+ * Keys of the vBucket are returned in lexicographical order, so the scan continues from the range
+ * that excludes the last returned key.
+ */
+auto
+resume_scan_type(const decltype(partition_range_scan_options::scan_type)& scan_type,
+                 const std::string& last_key) -> decltype(partition_range_scan_options::scan_type)
+{
+  if (const auto* range = std::get_if<couchbase::core::range_scan>(&scan_type); range != nullptr) {
+    auto resumed = *range;
+    resumed.from = couchbase::core::scan_term{ last_key, true };
+    return resumed;
+  }
+  if (const auto* prefix = std::get_if<couchbase::core::prefix_scan>(&scan_type);
+      prefix != nullptr) {
+    couchbase::core::range_scan resumed{};
+    resumed.from = couchbase::core::scan_term{ last_key, true };
+    resumed.to = couchbase::core::scan_term{ prefix->prefix + "\xff", false };
+    return resumed;
+  }
+  return scan_type;
+}
+
+/*
+ * Errors, after which the stream can be created again from the last received key. For example,
+ * when the vBucket moves to another node during rebalance, the connection to the old node might be
+ * closed, or the new node does not know the UUID of the scan (reported as "not found" by the
+ * continue request). Requests to the wrong node are retried by the agent itself.
+ */
+auto
+is_retryable_stream_error(std::error_code ec, bool continuing) -> bool
+{
+  return ec == couchbase::errc::common::temporary_failure ||
+         ec == couchbase::errc::common::request_canceled ||
+         (continuing && ec == couchbase::errc::key_value::document_not_found);
+}
+} // namespace
+
+partition_range_scan::partition_range_scan(couchbase::core::agent agent,
+                                           partition_range_scan_options options)
+  : agent_{ std::move(agent) }
+  , options_{ std::move(options) }
+{
+  /* vBuckets are taken from the back of the vector, so keep them in reverse order */
+  pending_vbuckets_.assign(options_.vbuckets.rbegin(), options_.vbuckets.rend());
+  if (const auto* sampling = std::get_if<couchbase::core::sampling_scan>(&options_.scan_type);
+      sampling != nullptr) {
+    items_left_ = sampling->limit;
+  }
+  options_.concurrency = std::max<std::uint16_t>(options_.concurrency, 1);
+  options_.buffer_size = std::max<std::size_t>(options_.buffer_size, 1);
+}
+
+void
+partition_range_scan::start()
+{
+  couchbase::core::get_collection_id_options collection_id_options{};
+  if (options_.timeout) {
+    collection_id_options.timeout = options_.timeout.value();
+  }
+  auto op = agent_.get_collection_id(
+    options_.scope_name,
+    options_.collection_name,
+    collection_id_options,
+    [self = shared_from_this()](couchbase::core::get_collection_id_result result,
+                                std::error_code ec) {
+      if (ec) {
+        return self->fail(ec);
+      }
+      {
+        std::scoped_lock lock(self->mutex_);
+        self->collection_id_ = result.collection_id;
+      }
+      self->start_streams();
+    });
+  if (!op.has_value()) {
+    fail(op.error());
+  }
+}
+
+void
+partition_range_scan::next(item_handler handler)
+{
+  {
+    std::scoped_lock lock(mutex_);
+    handler_ = std::move(handler);
+  }
+  deliver();
+}
+
+void
+partition_range_scan::cancel()
+{
+  std::vector<std::shared_ptr<stream>> paused_streams;
+  {
+    std::scoped_lock lock(mutex_);
+    if (cancelled_) {
+      return;
+    }
+    cancelled_ = true;
+    pending_vbuckets_.clear();
+    items_.clear();
+    /*
+     * Other streams are waiting for the response of create or continue request, and they are
+     * stopped by continue_stream() when it arrives.
+     */
+    for (const auto& s : active_streams_) {
+      if (s->paused) {
+        s->paused = false;
+        paused_streams.emplace_back(s);
+      }
+    }
+  }
+  for (const auto& s : paused_streams) {
+    continue_stream(s);
+  }
+  deliver();
+}
+
+auto
+partition_range_scan::options() const -> const partition_range_scan_options&
+{
+  return options_;
+}
+
+void
+partition_range_scan::start_streams()
+{
+  std::vector<std::shared_ptr<stream>> streams;
+  {
+    std::scoped_lock lock(mutex_);
+    while (!cancelled_ && !error_ && !pending_vbuckets_.empty() &&
+           active_streams_.size() < options_.concurrency) {
+      auto s = std::make_shared<stream>();
+      s->vbucket = pending_vbuckets_.back();
+      pending_vbuckets_.pop_back();
+      active_streams_.emplace_back(s);
+      streams.emplace_back(std::move(s));
+    }
+  }
+  for (const auto& s : streams) {
+    create_stream(s);
+  }
+  deliver();
+}
+
+void
+partition_range_scan::create_stream(std::shared_ptr<stream> s)
+{
+  couchbase::core::range_scan_create_options create_options{};
+  {
+    std::scoped_lock lock(mutex_);
+    create_options.collection_id = collection_id_;
+  }
+  create_options.scope_name = options_.scope_name;
+  create_options.collection_name = options_.collection_name;
+  create_options.scan_type = options_.scan_type;
+  std::optional<std::string> last_key{};
+  {
+    std::scoped_lock lock(mutex_);
+    last_key = s->last_key;
+  }
+  if (last_key) {
+    create_options.scan_type = resume_scan_type(options_.scan_type, last_key.value());
+  } else if (auto it = options_.resume_keys.find(s->vbucket); it != options_.resume_keys.end()) {
+    create_options.scan_type = resume_scan_type(options_.scan_type, it->second);
+  }
+  create_options.ids_only = options_.ids_only;
+  if (options_.timeout) {
+    create_options.timeout = options_.timeout.value();
+  }
+  if (auto it = options_.snapshot_requirements.find(s->vbucket);
+      it != options_.snapshot_requirements.end()) {
+    create_options.snapshot_requirements = it->second;
+  }
+
+  auto op = agent_.range_scan_create(
+    s->vbucket,
+    create_options,
+    [self = shared_from_this(), s](couchbase::core::range_scan_create_result result,
+                                   std::error_code ec) {
+      if (ec == couchbase::errc::key_value::document_not_found) {
+        /* there are no documents in the given range on this vBucket */
+        return self->complete_stream(s, {});
+      }
+      if (ec && self->retry_stream(s, ec, false)) {
+        return;
+      }
+      if (ec) {
+        return self->complete_stream(s, ec);
+      }
+      {
+        std::scoped_lock lock(self->mutex_);
+        s->scan_uuid = std::move(result.scan_uuid);
+      }
+      self->continue_stream(s);
+    });
+  if (!op.has_value()) {
+    complete_stream(s, op.error());
+  }
+}
+
+void
+partition_range_scan::continue_stream(std::shared_ptr<stream> s)
+{
+  bool stop = false;
+  std::vector<std::byte> scan_uuid{};
+  {
+    std::scoped_lock lock(mutex_);
+    scan_uuid = s->scan_uuid;
+    if (cancelled_ || error_ || items_left_ == 0U) {
+      stop = true;
+    } else if (items_.size() >= options_.buffer_size) {
+      /* the application does not keep up, resume when the buffer drains */
+      s->paused = true;
+      return;
+    }
+  }
+  if (stop) {
+    /* the server keeps the scan open until it is continued to the end, or cancelled */
+    cancel_stream(s->vbucket, std::move(scan_uuid));
+    return complete_stream(s, {});
+  }
+
+  couchbase::core::range_scan_continue_options continue_options{};
+  continue_options.ids_only = options_.ids_only;
+  if (options_.batch_item_limit) {
+    continue_options.batch_item_limit = options_.batch_item_limit.value();
+  }
+  if (options_.batch_byte_limit) {
+    continue_options.batch_byte_limit = options_.batch_byte_limit.value();
+  }
+  if (options_.timeout) {
+    continue_options.timeout = options_.timeout.value();
+  }
+
+  auto self = shared_from_this();
+  auto op = agent_.range_scan_continue(
+    std::move(scan_uuid),
+    s->vbucket,
+    continue_options,
+    [self, s](couchbase::core::range_scan_item item) {
+      self->on_item(s, std::move(item));
+    },
+    [self, s](couchbase::core::range_scan_continue_result result, std::error_code ec) {
+      if (ec && self->retry_stream(s, ec, true)) {
+        return;
+      }
+      if (ec) {
+        return self->complete_stream(s, ec);
+      }
+      if (result.complete || !result.more) {
+        return self->complete_stream(s, {});
+      }
+      self->continue_stream(s);
+    });
+  if (!op.has_value()) {
+    complete_stream(s, op.error());
+  }
+}
+
+void
+partition_range_scan::cancel_stream(std::uint16_t vbucket, std::vector<std::byte> scan_uuid)
+{
+  if (scan_uuid.empty()) {
+    return;
+  }
+  auto op = agent_.range_scan_cancel(
+    std::move(scan_uuid),
+    vbucket,
+    {},
+    [vbucket](couchbase::core::range_scan_cancel_result /* result */, std::error_code ec) {
+      if (ec) {
+        CB_LOG_DEBUG("unable to cancel range scan for vbucket {}: {}", vbucket, ec.message());
+      }
+    });
+  if (!op.has_value()) {
+    CB_LOG_DEBUG("unable to cancel range scan for vbucket {}: {}", vbucket, op.error().message());
+  }
+}
+
+auto
+partition_range_scan::retry_stream(const std::shared_ptr<stream>& s,
+                                   std::error_code ec,
+                                   bool continuing) -> bool
+{
+  if (!is_retryable_stream_error(ec, continuing)) {
+    return false;
+  }
+  std::vector<std::byte> scan_uuid{};
+  {
+    std::scoped_lock lock(mutex_);
+    if (cancelled_ || error_ || s->retries >= max_stream_retries) {
+      return false;
+    }
+    if (s->last_key &&
+        std::holds_alternative<couchbase::core::sampling_scan>(options_.scan_type)) {
+      /* the sampling scan cannot continue from the key, it would return the items again */
+      return false;
+    }
+    ++s->retries;
+    scan_uuid = std::exchange(s->scan_uuid, {});
+  }
+  CB_LOG_DEBUG("retry range scan for vbucket {} ({} of {}): {}",
+               s->vbucket,
+               s->retries,
+               max_stream_retries,
+               ec.message());
+  /* the scan might still be open on the node, if it only failed temporarily */
+  cancel_stream(s->vbucket, std::move(scan_uuid));
+  create_stream(s);
+  return true;
+}
+
+void
+partition_range_scan::complete_stream(const std::shared_ptr<stream>& s, std::error_code ec)
+{
+  {
+    std::scoped_lock lock(mutex_);
+    active_streams_.erase(std::remove(active_streams_.begin(), active_streams_.end(), s),
+                          active_streams_.end());
+    if (ec && !cancelled_ && !error_) {
+      CB_LOG_DEBUG("range scan failed for vbucket {}: {}", s->vbucket, ec.message());
+      error_ = ec;
+    } else if (!ec && !cancelled_ && !error_) {
+      items_.emplace_back(partition_scan_entry{ s->vbucket, {} });
+    }
+  }
+  start_streams();
+}
+
+void
+partition_range_scan::on_item(const std::shared_ptr<stream>& s,
+                              couchbase::core::range_scan_item item)
+{
+  {
+    std::scoped_lock lock(mutex_);
+    if (cancelled_ || error_ || items_left_ == 0U) {
+      return;
+    }
+    if (items_left_) {
+      --items_left_.value();
+    }
+    s->last_key = item.key;
+    items_.emplace_back(partition_scan_entry{ s->vbucket, std::move(item) });
+  }
+  deliver();
+}
+
+void
+partition_range_scan::resume_paused_streams()
+{
+  std::vector<std::shared_ptr<stream>> streams;
+  {
+    std::scoped_lock lock(mutex_);
+    if (items_.size() >= options_.buffer_size) {
+      return;
+    }
+    for (const auto& s : active_streams_) {
+      if (s->paused) {
+        s->paused = false;
+        streams.emplace_back(s);
+      }
+    }
+  }
+  for (const auto& s : streams) {
+    continue_stream(s);
+  }
+}
+
+void
+partition_range_scan::fail(std::error_code ec)
+{
+  {
+    std::scoped_lock lock(mutex_);
+    if (!error_) {
+      error_ = ec;
+    }
+  }
+  deliver();
+}
+
+/*
+ * Passes buffered items (or the final status) to the pending handler. The handler usually requests
+ * the next item right away, so the re-entrant calls are folded into the loop of the outer call.
+ */
+void
+partition_range_scan::deliver()
+{
+  {
+    std::scoped_lock lock(mutex_);
+    if (delivering_) {
+      return;
+    }
+    delivering_ = true;
+  }
+  while (true) {
+    item_handler handler;
+    partition_scan_entry entry{};
+    std::error_code ec{};
+    {
+      std::scoped_lock lock(mutex_);
+      if (!handler_) {
+        delivering_ = false;
+        break;
+      }
+      if (!items_.empty()) {
+        entry = std::move(items_.front());
+        items_.pop_front();
+      } else if (error_) {
+        ec = error_;
+      } else if (cancelled_ || items_left_ == 0U ||
+                 (pending_vbuckets_.empty() && active_streams_.empty())) {
+        ec = couchbase::errc::key_value::range_scan_completed;
+      } else {
+        delivering_ = false;
+        break;
+      }
+      handler = std::move(handler_.value());
+      handler_.reset();
+    }
+    handler(std::move(entry), ec);
+  }
+  resume_paused_streams();
+}
+} // namespace couchbase::php
@@ -0,0 +1,139 @@
+/**
+ * Copyright 2016-Present Couchbase, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <core/agent.hxx>
+#include <core/range_scan_options.hxx>
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <system_error>
+#include <variant>
+#include <vector>
+
+namespace couchbase::php
+{
+struct partition_range_scan_options {
+  std::string scope_name{};
+  std::string collection_name{};
+  std::variant<std::monostate,
+               couchbase::core::range_scan,
+               couchbase::core::prefix_scan,
+               couchbase::core::sampling_scan>
+    scan_type{};
+  std::vector<std::uint16_t> vbuckets{};
+  std::map<std::uint16_t, couchbase::core::range_snapshot_requirements> snapshot_requirements{};
+  /* last key returned to the application for the vBucket, the scan continues after this key */
+  std::map<std::uint16_t, std::string> resume_keys{};
+  std::optional<std::chrono::milliseconds> timeout{};
+  bool ids_only{ false };
+  std::uint16_t concurrency{ 1 };
+  std::optional<std::uint32_t> batch_item_limit{};
+  std::optional<std::uint32_t> batch_byte_limit{};
+  std::size_t buffer_size{ 1024 };
+};
+
+/**
+ * Item of the scan with the vBucket it belongs to. The entry without item marks that the vBucket has
+ * been scanned completely, and allows to maintain the checkpoint of the scan.
+ */
+struct partition_scan_entry {
+  std::uint16_t vbucket{};
+  std::optional<couchbase::core::range_scan_item> item{};
+};
+
+/**
+ * Scans only the given subset of the vBuckets, using range scan primitives of the agent directly.
+ *
+ * The core orchestrator always scans every vBucket of the map, so this class is used when the
+ * application splits the scan between several processes, or resumes the scan from the checkpoint.
+ * It exposes the same next()/cancel() interface as core::scan_result, but also reports the vBucket
+ * of every item.
+ *
+ * Like the orchestrator, it creates the stream of the vBucket again from the last received key,
+ * when the stream fails with a transient error (e.g. the vBucket has moved during rebalance). The
+ * number of retries is limited, and the sampling scan is not retried after it has returned items.
+ * In these cases the scan fails with the error of the stream, and can be resumed from the
+ * checkpoint.
+ */
+class partition_range_scan : public std::enable_shared_from_this<partition_range_scan>
+{
+public:
+  using item_handler = std::function<void(partition_scan_entry, std::error_code)>;
+
+  partition_range_scan(couchbase::core::agent agent, partition_range_scan_options options);
+
+  partition_range_scan(partition_range_scan&& other) = delete;
+
+  partition_range_scan(const partition_range_scan& other) = delete;
+
+  auto operator=(partition_range_scan&& other) -> partition_range_scan& = delete;
+
+  auto operator=(const partition_range_scan& other) -> partition_range_scan& = delete;
+
+  void start();
+
+  void next(item_handler handler);
+
+  void cancel();
+
+  [[nodiscard]] auto options() const -> const partition_range_scan_options&;
+
+private:
+  struct stream {
+    std::uint16_t vbucket{};
+    /* guarded by mutex_ */
+    std::vector<std::byte> scan_uuid{};
+    /* last key received from the server, guarded by mutex_ */
+    std::optional<std::string> last_key{};
+    std::size_t retries{ 0 };
+    bool paused{ false };
+  };
+
+  void start_streams();
+  void create_stream(std::shared_ptr<stream> s);
+  void continue_stream(std::shared_ptr<stream> s);
+  void cancel_stream(std::uint16_t vbucket, std::vector<std::byte> scan_uuid);
+  auto retry_stream(const std::shared_ptr<stream>& s, std::error_code ec, bool continuing) -> bool;
+  void complete_stream(const std::shared_ptr<stream>& s, std::error_code ec);
+  void on_item(const std::shared_ptr<stream>& s, couchbase::core::range_scan_item item);
+  void resume_paused_streams();
+  void fail(std::error_code ec);
+  void deliver();
+
+  couchbase::core::agent agent_;
+  partition_range_scan_options options_;
+
+  std::mutex mutex_{};
+  std::uint32_t collection_id_{ 0 };
+  std::vector<std::uint16_t> pending_vbuckets_{};
+  std::vector<std::shared_ptr<stream>> active_streams_{};
+  std::deque<partition_scan_entry> items_{};
+  std::optional<item_handler> handler_{};
+  std::optional<std::size_t> items_left_{};
+  std::error_code error_{};
+  bool cancelled_{ false };
+  bool delivering_{ false };
+};
+} // namespace couchbase::php
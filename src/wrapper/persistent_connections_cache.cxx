@@ -18,6 +18,7 @@
 
 #include "common.hxx"
 #include "connection_handle.hxx"
+#include "otlp_exporter.hxx"
 #include "transactions_resource.hxx"
 
 #include <core/logger/logger.hxx>
@@ -26,6 +27,12 @@
 
 #include <spdlog/fmt/bundled/chrono.h>
 
+#include <atomic>
+
+#ifndef _WIN32
+#include <pthread.h>
+#endif
+
 namespace couchbase::php
 {
 
@@ -285,6 +292,80 @@ get_fork_event(const zend_string* fork_event_str)
                          std::string_view(ZSTR_VAL(fork_event_str), ZSTR_LEN(fork_event_str))) },
            {} };
 }
+
+void
+notify_persistent_resources(fork_event event)
+{
+  /* transactions must be first to stop */
+  if (event == fork_event::prepare) {
+    zend_hash_apply_with_argument(&EG(persistent_list), notify_transaction, &event);
+  }
+
+  /* the thread of the exporter does not survive fork() */
+  if (auto exporter = current_otlp_exporter(); exporter) {
+    if (event == fork_event::prepare) {
+      exporter->stop();
+    } else {
+      exporter->start();
+    }
+  }
+
+  zend_hash_apply_with_argument(&EG(persistent_list), notify_connection, &event);
+
+  /* transactions must be last to start */
+  if (event != fork_event::prepare) {
+    zend_hash_apply_with_argument(&EG(persistent_list), notify_transaction, &event);
+  }
+}
+
+enum class fork_state {
+  idle,
+  prepared_manually,
+  prepared_automatically,
+};
+
+std::atomic<fork_state> fork_state_{ fork_state::idle };
+std::atomic_bool fork_handlers_registered_{ false };
+std::atomic_bool fork_handlers_enabled_{ false };
+
+#ifndef _WIN32
+void
+fork_handler_prepare()
+{
+  if (!fork_handlers_enabled_) {
+    return;
+  }
+  auto expected = fork_state::idle;
+  if (!fork_state_.compare_exchange_strong(expected, fork_state::prepared_automatically)) {
+    /* the application has already called notifyFork("prepare") */
+    return;
+  }
+  notify_persistent_resources(fork_event::prepare);
+}
+
+void
+fork_handler_resume(fork_event event)
+{
+  auto expected = fork_state::prepared_automatically;
+  if (!fork_state_.compare_exchange_strong(expected, fork_state::idle)) {
+    /* the application will call notifyFork("parent"|"child") itself */
+    return;
+  }
+  notify_persistent_resources(event);
+}
+
+void
+fork_handler_parent()
+{
+  fork_handler_resume(fork_event::parent);
+}
+
+void
+fork_handler_child()
+{
+  fork_handler_resume(fork_event::child);
+}
+#endif
 } // namespace
 
 COUCHBASE_API
@@ -296,18 +377,41 @@ notify_fork(const zend_string* fork_event) -> core_error_info
     return e;
   }
 
-  /* transactions must be first to stop */
   if (event == fork_event::prepare) {
-    zend_hash_apply_with_argument(&EG(persistent_list), notify_transaction, &event);
+    fork_state_ = fork_state::prepared_manually;
+  } else if (auto state = fork_state_.exchange(fork_state::idle);
+             state != fork_state::prepared_manually && fork_handlers_enabled_) {
+    /* fork handlers have already resumed the library, or nothing has been prepared */
+    CB_LOG_DEBUG("ignore notifyFork(\"{}\"), because the library has not been prepared manually",
+                 std::string_view(ZSTR_VAL(fork_event), ZSTR_LEN(fork_event)));
+    return {};
   }
 
-  zend_hash_apply_with_argument(&EG(persistent_list), notify_connection, &event);
+  notify_persistent_resources(event.value());
 
-  /* transactions must be last to start */
-  if (event != fork_event::prepare) {
-    zend_hash_apply_with_argument(&EG(persistent_list), notify_transaction, &event);
+  return {};
+}
+
+COUCHBASE_API
+void
+enable_fork_handlers()
+{
+#ifndef _WIN32
+  if (!fork_handlers_registered_.exchange(true)) {
+    /* handlers cannot be unregistered, so they are registered once and toggled by the flag */
+    if (pthread_atfork(fork_handler_prepare, fork_handler_parent, fork_handler_child) != 0) {
+      fork_handlers_registered_ = false;
+      return;
+    }
   }
+  fork_handlers_enabled_ = true;
+#endif
+}
 
-  return {};
+COUCHBASE_API
+void
+disable_fork_handlers()
+{
+  fork_handlers_enabled_ = false;
 }
 } // namespace couchbase::php
@@ -45,4 +45,14 @@ check_persistent_connection(zval* zv);
 COUCHBASE_API
 core_error_info
 notify_fork(const zend_string* fork_event);
+
+/**
+ * Registers pthread_atfork() handlers, that invoke notify_fork() logic automatically around fork().
+ * Explicit notifyFork() calls from the application take precedence over the handlers.
+ */
+COUCHBASE_API void
+enable_fork_handlers();
+
+COUCHBASE_API void
+disable_fork_handlers();
 } // namespace couchbase::php
@@ -18,6 +18,7 @@
 
 #include "common.hxx"
 #include "conversion_utilities.hxx"
+#include "partition_range_scan.hxx"
 #include "scan_result_resource.hxx"
 
 #include <core/agent_group.hxx>
@@ -25,15 +26,26 @@
 #include <core/range_scan_options.hxx>
 #include <core/range_scan_orchestrator.hxx>
 #include <core/range_scan_orchestrator_options.hxx>
+#include <core/utils/json.hxx>
 
 #include <spdlog/fmt/bundled/core.h>
 
+#include <algorithm>
 #include <array>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string_view>
 #include <thread>
+#include <type_traits>
+#include <variant>
+#include <vector>
 
 namespace couchbase::php
 {
 static int scan_result_destructor_id_{ 0 };
+constexpr std::size_t default_scan_prefetch_size{ 1024 };
 
 void
 set_scan_result_destructor_id(int id)
@@ -47,12 +59,172 @@ get_scan_result_destructor_id()
   return scan_result_destructor_id_;
 }
 
+/* items come either from the core orchestrator, or from the scan over a subset of vBuckets */
+using scan_source = std::variant<std::unique_ptr<couchbase::core::scan_result>,
+                                 std::shared_ptr<partition_range_scan>>;
+
+namespace
+{
+/* field name, or index of the array element */
+using projection_path = std::vector<std::variant<std::string, std::size_t>>;
+
+/*
+ * Parses sub-document path like "address.lines[0]", every dot-separated part must start with the
+ * field name.
+ */
+auto
+parse_projection_path(std::string_view path) -> std::optional<projection_path>
+{
+  projection_path result{};
+  std::size_t pos{ 0 };
+  while (pos <= path.size()) {
+    auto end = std::min(path.find('.', pos), path.size());
+    auto part = path.substr(pos, end - pos);
+    auto name = part.substr(0, part.find('['));
+    if (name.empty()) {
+      return {};
+    }
+    result.emplace_back(std::string{ name });
+    part.remove_prefix(name.size());
+    while (!part.empty()) {
+      auto close = part.find(']');
+      if (part.front() != '[' || close == std::string_view::npos || close == 1) {
+        return {};
+      }
+      std::size_t index{ 0 };
+      for (auto ch : part.substr(1, close - 1)) {
+        if (ch < '0' || ch > '9') {
+          return {};
+        }
+        index = index * 10 + static_cast<std::size_t>(ch - '0');
+      }
+      result.emplace_back(index);
+      part.remove_prefix(close + 1);
+    }
+    pos = end + 1;
+  }
+  return result;
+}
+
+auto
+parse_projection_paths(const std::vector<std::string>& projections) -> std::vector<projection_path>
+{
+  std::vector<projection_path> result{};
+  result.reserve(projections.size());
+  for (const auto& projection : projections) {
+    if (auto path = parse_projection_path(projection); path) {
+      result.emplace_back(std::move(path.value()));
+    }
+  }
+  return result;
+}
+
+/*
+ * Copies the value at the path into the projected document, re-creating parent objects (and
+ * arrays, where the path refers to array elements) in the same way as projections of the get
+ * operation.
+ */
+void
+project_path(const tao::json::value& document,
+             const projection_path& path,
+             tao::json::value& projected)
+{
+  const tao::json::value* source = &document;
+  for (const auto& element : path) {
+    if (const auto* name = std::get_if<std::string>(&element); name != nullptr) {
+      if (!source->is_object()) {
+        return;
+      }
+      source = source->find(*name);
+    } else {
+      auto index = std::get<std::size_t>(element);
+      if (!source->is_array() || index >= source->get_array().size()) {
+        return;
+      }
+      source = &source->get_array()[index];
+    }
+    if (source == nullptr) {
+      return;
+    }
+  }
+
+  tao::json::value* target = &projected;
+  for (std::size_t i = 0; i < path.size(); ++i) {
+    const bool last = i + 1 == path.size();
+    tao::json::value next = tao::json::empty_object;
+    if (last) {
+      next = *source;
+    } else if (std::holds_alternative<std::size_t>(path[i + 1])) {
+      next = tao::json::empty_array;
+    }
+    if (const auto* name = std::get_if<std::string>(&path[i]); name != nullptr) {
+      if (!target->is_object()) {
+        return;
+      }
+      auto& object = target->get_object();
+      auto it = object.find(*name);
+      if (it == object.end() || last) {
+        it = object.insert_or_assign(*name, std::move(next)).first;
+      }
+      target = &it->second;
+    } else {
+      if (!target->is_array()) {
+        return;
+      }
+      auto& array = target->get_array();
+      array.emplace_back(std::move(next));
+      target = &array.back();
+    }
+  }
+}
+
+/*
+ * Replaces JSON body of the item with the document that contains only the given paths. Bodies
+ * that are not JSON are left untouched.
+ */
+void
+project_item(couchbase::core::range_scan_item& item, const std::vector<projection_path>& paths)
+{
+  if (paths.empty() || !item.body.has_value()) {
+    return;
+  }
+  auto& body = item.body.value();
+  tao::json::value document;
+  try {
+    document = core::utils::json::parse_binary(body.value);
+  } catch (const tao::pegtl::parse_error&) {
+    return;
+  }
+  tao::json::value projected = tao::json::empty_object;
+  for (const auto& path : paths) {
+    project_path(document, path, projected);
+  }
+  body.value = core::utils::json::generate_binary(projected);
+}
+} // namespace
+
+/* progress of the scan over single vBucket, as seen by the application */
+struct vbucket_checkpoint {
+  std::optional<std::string> last_key{};
+  std::optional<couchbase::core::range_snapshot_requirements> snapshot_requirements{};
+  bool completed{ false };
+};
+
+using scan_checkpoint = std::map<std::uint16_t, vbucket_checkpoint>;
+
 class scan_result_resource::impl : public std::enable_shared_from_this<scan_result_resource::impl>
 {
 public:
-  impl(connection_handle* connection, std::unique_ptr<couchbase::core::scan_result> scan_result)
+  impl(connection_handle* connection,
+       scan_source scan_result,
+       std::size_t prefetch_size,
+       std::vector<projection_path> projections,
+       std::optional<scan_checkpoint> checkpoint)
     : cluster_{ connection->cluster() }
     , scan_result_{ std::move(scan_result) }
+    , prefetch_size_{ std::max<std::size_t>(prefetch_size, 1) }
+    , projections_{ std::move(projections) }
+    , checkpoint_{ std::move(checkpoint) }
   {
   }
 
@@ -67,39 +239,255 @@ public:
   [[nodiscard]] std::pair<std::optional<couchbase::core::range_scan_item>, core_error_info>
   next_item()
   {
-    auto barrier = std::make_shared<
-      std::promise<tl::expected<couchbase::core::range_scan_item, std::error_code>>>();
-    auto f = barrier->get_future();
-    scan_result_->next([barrier](couchbase::core::range_scan_item item, std::error_code ec) {
-      if (ec) {
-        return barrier->set_value(tl::unexpected(ec));
+    std::vector<couchbase::core::range_scan_item> items;
+    auto err = next_batch(items, 1);
+    if (err.ec || items.empty()) {
+      return { {}, err };
+    }
+    return { std::move(items.front()), {} };
+  }
+
+  /*
+   * Waits until at least one item is available in the prefetch buffer (or the scan completes), and
+   * moves up to limit items into the output vector.
+   *
+   * Requesting the next batch means that the application has processed the previous one, so its
+   * entries are applied to the checkpoint. The projections are applied to the returned items.
+   */
+  [[nodiscard]] core_error_info next_batch(std::vector<couchbase::core::range_scan_item>& items,
+                                           std::size_t limit)
+  {
+    {
+      std::scoped_lock lock(mutex_);
+      if (checkpoint_) {
+        apply_batch(checkpoint_.value(), last_batch_.size());
       }
-      return barrier->set_value(std::move(item));
-    });
-    auto resp = f.get();
-    if (!resp.has_value()) {
-      if (resp.error() != couchbase::errc::key_value::range_scan_completed) {
-        return { {}, { resp.error(), ERROR_LOCATION, "Unable to fetch scan item" } };
+      last_batch_.clear();
+    }
+    while (true) {
+      prefetch();
+      std::unique_lock lock(mutex_);
+      buffer_updated_.wait(lock, [this]() {
+        return !buffer_.empty() || completed_;
+      });
+      items.reserve(std::min(limit, buffer_.size()));
+      while (!buffer_.empty() && items.size() < limit) {
+        auto entry = std::move(buffer_.front());
+        buffer_.pop_front();
+        if (checkpoint_) {
+          last_batch_.emplace_back(
+            entry.vbucket,
+            entry.item ? std::make_optional(entry.item->key) : std::optional<std::string>{});
+        }
+        if (entry.item) {
+          items.emplace_back(std::move(entry.item.value()));
+        }
       }
-      return { {}, {} };
+      if (!items.empty()) {
+        break;
+      }
+      if (buffer_.empty() && completed_) {
+        if (error_) {
+          return { error_, ERROR_LOCATION, "Unable to fetch scan item" };
+        }
+        return {};
+      }
+      /* only markers of completed vBuckets were buffered, wait for the items */
     }
-    return { resp.value(), {} };
+    prefetch();
+    /* projected on the thread of PHP, so that the I/O threads only move the items */
+    for (auto& item : items) {
+      project_item(item, projections_);
+    }
+    return {};
+  }
+
+  /*
+   * Returns the checkpoint after the application has processed the given number of items from the
+   * last batch.
+   */
+  [[nodiscard]] std::optional<scan_checkpoint> checkpoint(std::size_t processed_items)
+  {
+    std::scoped_lock lock(mutex_);
+    if (!checkpoint_) {
+      return {};
+    }
+    auto result = checkpoint_.value();
+    apply_batch(result, processed_items);
+    return result;
+  }
+
+  void cancel()
+  {
+    {
+      std::scoped_lock lock(mutex_);
+      if (completed_) {
+        return;
+      }
+      completed_ = true;
+    }
+    std::visit(
+      [](auto& source) {
+        source->cancel();
+      },
+      scan_result_);
+    buffer_updated_.notify_all();
   }
 
 private:
+  /*
+   * Keeps at most one next() request in flight, and chains the next request from the completion
+   * handler until the buffer is full, so that the orchestrator keeps streaming the items from all
+   * vBuckets while the application processes the ones that are already buffered.
+   */
+  void prefetch()
+  {
+    {
+      std::scoped_lock lock(mutex_);
+      if (fetching_ || completed_ || buffer_.size() >= prefetch_size_) {
+        return;
+      }
+      fetching_ = true;
+    }
+    std::visit(
+      [self = shared_from_this()](auto& source) {
+        using source_type = std::decay_t<decltype(source)>;
+        if constexpr (std::is_same_v<source_type, std::shared_ptr<partition_range_scan>>) {
+          source->next([self](partition_scan_entry entry, std::error_code ec) {
+            self->on_entry(std::move(entry), ec);
+          });
+        } else {
+          source->next([self](couchbase::core::range_scan_item item, std::error_code ec) {
+            self->on_entry(partition_scan_entry{ 0, std::move(item) }, ec);
+          });
+        }
+      },
+      scan_result_);
+  }
+
+  void on_entry(partition_scan_entry entry, std::error_code ec)
+  {
+    {
+      std::scoped_lock lock(mutex_);
+      fetching_ = false;
+      if (ec) {
+        completed_ = true;
+        if (ec != couchbase::errc::key_value::range_scan_completed) {
+          error_ = ec;
+        }
+      } else if (!completed_) {
+        buffer_.emplace_back(std::move(entry));
+      }
+    }
+    buffer_updated_.notify_all();
+    prefetch();
+  }
+
+  /*
+   * Applies entries of the last batch up to the given number of items, including the completion
+   * markers that follow the last applied item.
+   */
+  void apply_batch(scan_checkpoint& checkpoint, std::size_t processed_items) const
+  {
+    std::size_t applied_items{ 0 };
+    for (const auto& [vbucket, key] : last_batch_) {
+      if (key) {
+        if (applied_items == processed_items) {
+          break;
+        }
+        ++applied_items;
+        checkpoint[vbucket].last_key = key;
+      } else {
+        checkpoint[vbucket].completed = true;
+      }
+    }
+  }
+
   couchbase::core::cluster cluster_;
-  std::unique_ptr<couchbase::core::scan_result> scan_result_;
+  scan_source scan_result_;
+  std::size_t prefetch_size_;
+  std::vector<projection_path> projections_;
+
+  std::mutex mutex_{};
+  std::condition_variable buffer_updated_{};
+  std::deque<partition_scan_entry> buffer_{};
+  bool fetching_{ false };
+  bool completed_{ false };
+  std::error_code error_{};
+
+  /* only scans over the explicit set of vBuckets maintain the checkpoint */
+  std::optional<scan_checkpoint> checkpoint_{};
+  std::vector<std::pair<std::uint16_t, std::optional<std::string>>> last_batch_{};
 };
 
+namespace
+{
+void
+scan_item_to_zval(zval* return_value, const couchbase::core::range_scan_item& item)
+{
+  array_init(return_value);
+  add_assoc_stringl(return_value, "id", item.key.data(), item.key.size());
+  if (item.body.has_value()) {
+    const auto& body = item.body.value();
+    auto cas = fmt::format("{:x}", body.cas.value());
+    add_assoc_stringl(return_value, "cas", cas.data(), cas.size());
+    add_assoc_long(return_value, "flags", body.flags);
+    add_assoc_stringl(
+      return_value, "value", reinterpret_cast<const char*>(body.value.data()), body.value.size());
+    add_assoc_long(return_value, "expiry", body.expiry);
+    add_assoc_bool(return_value, "idsOnly", false);
+  } else {
+    add_assoc_bool(return_value, "idsOnly", true);
+  }
+}
+} // namespace
+
 COUCHBASE_API
 scan_result_resource::scan_result_resource(connection_handle* connection,
-                                           const couchbase::core::scan_result& scan_result)
+                                           const couchbase::core::scan_result& scan_result,
+                                           std::size_t prefetch_size,
+                                           const std::vector<std::string>& projections)
   : impl_{ std::make_shared<scan_result_resource::impl>(
       connection,
-      std::make_unique<couchbase::core::scan_result>(scan_result)) }
+      std::make_unique<couchbase::core::scan_result>(scan_result),
+      prefetch_size,
+      parse_projection_paths(projections),
+      std::nullopt) }
 {
 }
 
+COUCHBASE_API
+scan_result_resource::scan_result_resource(connection_handle* connection,
+                                           std::shared_ptr<partition_range_scan> scan,
+                                           std::size_t prefetch_size,
+                                           const std::vector<std::string>& projections)
+  : impl_{ nullptr }
+{
+  scan_checkpoint checkpoint{};
+  const auto& options = scan->options();
+  for (auto vbucket : options.vbuckets) {
+    auto& state = checkpoint[vbucket];
+    if (auto it = options.resume_keys.find(vbucket); it != options.resume_keys.end()) {
+      state.last_key = it->second;
+    }
+    if (auto it = options.snapshot_requirements.find(vbucket);
+        it != options.snapshot_requirements.end()) {
+      state.snapshot_requirements = it->second;
+    }
+  }
+  impl_ = std::make_shared<scan_result_resource::impl>(connection,
+                                                       std::move(scan),
+                                                       prefetch_size,
+                                                       parse_projection_paths(projections),
+                                                       std::move(checkpoint));
+}
+
+COUCHBASE_API
+scan_result_resource::~scan_result_resource()
+{
+  impl_->cancel();
+}
+
 COUCHBASE_API
 core_error_info
 scan_result_resource::next_item(zval* return_value)
@@ -109,21 +497,70 @@ scan_result_resource::next_item(zval* return_value)
     return err;
   }
   if (resp) {
-    array_init(return_value);
-    add_assoc_stringl(return_value, "id", resp->key.data(), resp->key.size());
-    if (resp->body.has_value()) {
-      auto body = resp->body.value();
-      auto cas = fmt::format("{:x}", body.cas.value());
-      add_assoc_stringl(return_value, "cas", cas.data(), cas.size());
-      add_assoc_long(return_value, "flags", body.flags);
-      add_assoc_stringl(
-        return_value, "value", reinterpret_cast<const char*>(body.value.data()), body.value.size());
-      add_assoc_long(return_value, "expiry", body.expiry);
-      add_assoc_bool(return_value, "idsOnly", false);
-    } else {
-      add_assoc_bool(return_value, "idsOnly", true);
+    scan_item_to_zval(return_value, resp.value());
+  }
+  return {};
+}
+
+COUCHBASE_API
+core_error_info
+scan_result_resource::next_batch(zval* return_value, zend_long limit)
+{
+  if (limit <= 0) {
+    return { errc::common::invalid_argument,
+             ERROR_LOCATION,
+             "expected limit for scan batch to be a positive number" };
+  }
+  std::vector<couchbase::core::range_scan_item> items;
+  if (auto err = impl_->next_batch(items, static_cast<std::size_t>(limit)); err.ec) {
+    return err;
+  }
+  if (items.empty()) {
+    return {};
+  }
+  array_init_size(return_value, static_cast<uint32_t>(items.size()));
+  for (const auto& item : items) {
+    zval entry;
+    scan_item_to_zval(&entry, item);
+    add_next_index_zval(return_value, &entry);
+  }
+  return {};
+}
+
+COUCHBASE_API
+core_error_info
+scan_result_resource::checkpoint(zval* return_value, zend_long processed_items)
+{
+  auto checkpoint =
+    impl_->checkpoint(static_cast<std::size_t>(std::max<zend_long>(processed_items, 0)));
+  if (!checkpoint) {
+    return { errc::common::invalid_argument,
+             ERROR_LOCATION,
+             "checkpoint is only available for resumable or partitioned scans" };
+  }
+  array_init(return_value);
+  zval vbuckets;
+  array_init(&vbuckets);
+  for (const auto& [vbucket, state] : checkpoint.value()) {
+    if (state.completed) {
+      continue;
     }
+    zval entry;
+    array_init(&entry);
+    add_assoc_long(&entry, "vbucket", vbucket);
+    if (state.last_key) {
+      add_assoc_stringl(&entry, "lastKey", state.last_key->data(), state.last_key->size());
+    }
+    if (state.snapshot_requirements) {
+      /* 64-bit unsigned values are exposed as hex strings, like in mutation tokens */
+      auto val = fmt::format("{:x}", state.snapshot_requirements->vbucket_uuid);
+      add_assoc_stringl(&entry, "vbucketUuid", val.data(), val.size());
+      val = fmt::format("{:x}", state.snapshot_requirements->sequence_number);
+      add_assoc_stringl(&entry, "sequenceNumber", val.data(), val.size());
+    }
+    add_next_index_zval(&vbuckets, &entry);
   }
+  add_assoc_zval(return_value, "vbuckets", &vbuckets);
   return {};
 }
 
@@ -154,6 +591,45 @@ create_scan_result_resource(connection_handle* connection,
   if (auto e = cb_assign_integer(opts.batch_item_limit, options, "batchItemLimit"); e.ec) {
     return { nullptr, e };
   }
+  std::vector<std::string> projections{};
+  if (auto e = cb_assign_vector_of_strings(projections, options, "projections"); e.ec) {
+    return { nullptr, e };
+  }
+  for (const auto& projection : projections) {
+    if (!parse_projection_path(projection)) {
+      return { nullptr,
+               { errc::common::invalid_argument,
+                 ERROR_LOCATION,
+                 fmt::format("unsupported projection path: \"{}\"", projection) } };
+    }
+  }
+  std::size_t prefetch_size{ default_scan_prefetch_size };
+  if (auto e = cb_assign_integer(prefetch_size, options, "prefetchSize"); e.ec) {
+    return { nullptr, e };
+  }
+  auto [partition_index_error, partition_index] =
+    cb_get_integer<std::uint16_t>(options, "partitionIndex");
+  if (partition_index_error.ec) {
+    return { nullptr, partition_index_error };
+  }
+  auto [partition_count_error, partition_count] =
+    cb_get_integer<std::uint16_t>(options, "partitionCount");
+  if (partition_count_error.ec) {
+    return { nullptr, partition_count_error };
+  }
+  if (partition_count.has_value() != partition_index.has_value()) {
+    return { nullptr,
+             { errc::common::invalid_argument,
+               ERROR_LOCATION,
+               "partitionIndex and partitionCount must be specified together" } };
+  }
+  if (partition_count && (partition_count.value() == 0 ||
+                          partition_index.value() >= partition_count.value())) {
+    return { nullptr,
+             { errc::common::invalid_argument,
+               ERROR_LOCATION,
+               "partitionIndex must be less than partitionCount" } };
+  }
   if (const zval* value = zend_symtable_str_find(Z_ARRVAL_P(options), ZEND_STRL("consistentWith"));
       value != nullptr && Z_TYPE_P(value) == IS_ARRAY) {
     couchbase::core::mutation_state mutation_state{};
@@ -285,6 +761,127 @@ create_scan_result_resource(connection_handle* connection,
   } else if (e.ec) {
     return { nullptr, e };
   }
+  bool resumable{ false };
+  if (auto e = cb_assign_boolean(resumable, options, "resumable"); e.ec) {
+    return { nullptr, e };
+  }
+  std::optional<std::vector<std::uint16_t>> resume_vbuckets{};
+  std::map<std::uint16_t, std::string> resume_keys{};
+  std::map<std::uint16_t, couchbase::core::range_snapshot_requirements> resume_snapshots{};
+  if (const zval* resume_from =
+        zend_symtable_str_find(Z_ARRVAL_P(options), ZEND_STRL("resumeFrom"));
+      resume_from != nullptr && Z_TYPE_P(resume_from) == IS_ARRAY) {
+    const zval* vbuckets = zend_symtable_str_find(Z_ARRVAL_P(resume_from), ZEND_STRL("vbuckets"));
+    if (vbuckets == nullptr || Z_TYPE_P(vbuckets) != IS_ARRAY) {
+      return { nullptr,
+               { errc::common::invalid_argument,
+                 ERROR_LOCATION,
+                 "expected \"vbuckets\" of the scan checkpoint to be an array" } };
+    }
+    if (std::holds_alternative<couchbase::core::sampling_scan>(core_scan_type)) {
+      return { nullptr,
+               { errc::common::invalid_argument,
+                 ERROR_LOCATION,
+                 "sampling scan cannot be resumed from the checkpoint" } };
+    }
+    resume_vbuckets.emplace();
+    const zval* entry = nullptr;
+    ZEND_HASH_FOREACH_VAL(Z_ARRVAL_P(vbuckets), entry)
+    {
+      if (Z_TYPE_P(entry) != IS_ARRAY) {
+        return { nullptr,
+                 { errc::common::invalid_argument,
+                   ERROR_LOCATION,
+                   "expected entry of the scan checkpoint to be an array" } };
+      }
+      auto [vbucket_error, vbucket] = cb_get_integer<std::uint16_t>(entry, "vbucket");
+      if (vbucket_error.ec) {
+        return { nullptr, vbucket_error };
+      }
+      if (!vbucket || vbucket.value() >= vbucket_map->size()) {
+        return { nullptr,
+                 { errc::common::invalid_argument,
+                   ERROR_LOCATION,
+                   "scan checkpoint does not match vBucket map of the bucket" } };
+      }
+      resume_vbuckets->emplace_back(vbucket.value());
+      auto [key_error, last_key] = cb_get_string(entry, "lastKey");
+      if (key_error.ec) {
+        return { nullptr, key_error };
+      }
+      if (last_key) {
+        resume_keys[vbucket.value()] = last_key.value();
+      }
+      auto [uuid_error, vbucket_uuid] = cb_get_integer<std::uint64_t>(entry, "vbucketUuid");
+      if (uuid_error.ec) {
+        return { nullptr, uuid_error };
+      }
+      auto [seqno_error, sequence_number] = cb_get_integer<std::uint64_t>(entry, "sequenceNumber");
+      if (seqno_error.ec) {
+        return { nullptr, seqno_error };
+      }
+      if (vbucket_uuid && sequence_number) {
+        resume_snapshots[vbucket.value()] = couchbase::core::range_snapshot_requirements{
+          vbucket_uuid.value(),
+          sequence_number.value(),
+          true,
+        };
+      }
+    }
+    ZEND_HASH_FOREACH_END();
+  }
+  if (resumable && std::holds_alternative<couchbase::core::sampling_scan>(core_scan_type)) {
+    return { nullptr,
+             { errc::common::invalid_argument,
+               ERROR_LOCATION,
+               "sampling scan cannot be resumable" } };
+  }
+
+  if (partition_count || resumable || resume_vbuckets) {
+    partition_range_scan_options partition_options{};
+    partition_options.scope_name = scope_name;
+    partition_options.collection_name = collection_name;
+    partition_options.scan_type = core_scan_type;
+    partition_options.timeout = opts.timeout;
+    partition_options.ids_only = opts.ids_only;
+    partition_options.concurrency = opts.concurrency;
+    partition_options.batch_item_limit = opts.batch_item_limit;
+    partition_options.batch_byte_limit = opts.batch_byte_limit;
+    partition_options.buffer_size = prefetch_size;
+    if (resume_vbuckets) {
+      /* the checkpoint lists only vBuckets that still have to be scanned */
+      partition_options.vbuckets = std::move(resume_vbuckets.value());
+      partition_options.resume_keys = std::move(resume_keys);
+    } else {
+      const std::size_t step = partition_count.value_or(1);
+      for (std::size_t vbucket = partition_index.value_or(0); vbucket < vbucket_map->size();
+           vbucket += step) {
+        partition_options.vbuckets.emplace_back(static_cast<std::uint16_t>(vbucket));
+      }
+    }
+    if (opts.consistent_with) {
+      for (const auto& token : opts.consistent_with->tokens) {
+        partition_options.snapshot_requirements[token.partition_id()] =
+          couchbase::core::range_snapshot_requirements{
+            token.partition_uuid(),
+            token.sequence_number(),
+            true,
+          };
+      }
+    }
+    /* the resumed scan keeps the snapshot it has been started with */
+    for (auto& [vbucket, requirements] : resume_snapshots) {
+      partition_options.snapshot_requirements[vbucket] = requirements;
+    }
+    auto scan = std::make_shared<partition_range_scan>(agent.value(), std::move(partition_options));
+    scan->start();
+
+    auto* handle =
+      new scan_result_resource(connection, std::move(scan), prefetch_size, projections);
+
+    return { zend_register_resource(handle, scan_result_destructor_id_), {} };
+  }
+
   auto orchestrator = couchbase::core::range_scan_orchestrator(clust.io_context(),
                                                                agent.value(),
                                                                vbucket_map.value(),
@@ -299,7 +896,7 @@ create_scan_result_resource(connection_handle* connection,
     return { nullptr, { resp.error(), ERROR_LOCATION, "Unable to start the scan" } };
   }
 
-  auto* handle = new scan_result_resource(connection, resp.value());
+  auto* handle = new scan_result_resource(connection, resp.value(), prefetch_size, projections);
 
   return { zend_register_resource(handle, scan_result_destructor_id_), {} };
 }
@@ -26,6 +26,7 @@
 #include <memory>
 #include <string>
 #include <system_error>
+#include <vector>
 
 namespace couchbase
 {
@@ -37,16 +38,35 @@ class scan_result;
 
 namespace couchbase::php
 {
+class partition_range_scan;
+
 class scan_result_resource
 {
 public:
   COUCHBASE_API
   scan_result_resource(connection_handle* connection,
-                       const couchbase::core::scan_result& scan_result);
+                       const couchbase::core::scan_result& scan_result,
+                       std::size_t prefetch_size,
+                       const std::vector<std::string>& projections);
+
+  COUCHBASE_API
+  scan_result_resource(connection_handle* connection,
+                       std::shared_ptr<partition_range_scan> scan,
+                       std::size_t prefetch_size,
+                       const std::vector<std::string>& projections);
+
+  COUCHBASE_API
+  ~scan_result_resource();
 
   COUCHBASE_API
   core_error_info next_item(zval* return_value);
 
+  COUCHBASE_API
+  core_error_info next_batch(zval* return_value, zend_long limit);
+
+  COUCHBASE_API
+  core_error_info checkpoint(zval* return_value, zend_long processed_items);
+
 private:
   class impl;
 
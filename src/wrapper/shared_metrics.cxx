@@ -0,0 +1,442 @@
+/**
+ * Copyright 2016-Present Couchbase, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "shared_metrics.hxx"
+
+#include "common.hxx"
+
+#include <core/logger/logger.hxx>
+
+#include <spdlog/fmt/bundled/core.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <new>
+#include <thread>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace couchbase::php
+{
+namespace
+{
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free &&
+                std::atomic<std::int64_t>::is_always_lock_free &&
+                std::atomic<std::uint32_t>::is_always_lock_free,
+              "the counters in the shared memory must be lock-free");
+
+/* layout of the segment must be changed together with the version */
+constexpr std::uint64_t segment_magic{ 0x4342'4d45'5452'4943 };
+constexpr std::uint32_t segment_version{ 1 };
+constexpr std::size_t groups_per_slot{ 64 };
+constexpr std::size_t key_size{ 192 };
+constexpr std::size_t header_size{ 64 };
+
+enum entry_state : std::uint32_t {
+  entry_free = 0,
+  entry_initializing = 1,
+  entry_ready = 2,
+};
+
+using encoded_key = std::array<char, key_size>;
+
+struct alignas(64) shared_group_entry {
+  std::atomic<std::uint32_t> state;
+  /* service, operation and bucket, separated by zero bytes */
+  encoded_key key;
+  alignas(operation_group) unsigned char storage[sizeof(operation_group)];
+
+  auto group() -> operation_group*
+  {
+    return std::launder(reinterpret_cast<operation_group*>(storage));
+  }
+};
+
+struct alignas(64) shared_slot {
+  /* process that writes into the slot, zero if the slot has never been used */
+  std::atomic<std::int64_t> owner;
+  std::array<shared_group_entry, groups_per_slot> entries;
+};
+
+struct segment_header {
+  std::atomic<std::uint64_t> magic;
+  std::uint32_t version;
+  std::uint32_t slot_count;
+  std::uint64_t slot_size;
+};
+static_assert(sizeof(segment_header) <= header_size);
+
+struct shared_segment {
+  segment_header* header{ nullptr };
+  shared_slot* slots{ nullptr };
+  std::uint32_t slot_count{ 0 };
+  /* the slot is claimed lazily, and again after fork() */
+  std::int64_t slot_owner{ 0 };
+  shared_slot* slot{ nullptr };
+  bool slots_exhausted_reported{ false };
+};
+
+std::mutex segment_mutex{};
+shared_segment segment{};
+std::once_flag segment_initialized{};
+
+auto
+encode_key(std::string_view service, std::string_view operation, std::string_view bucket)
+  -> std::optional<encoded_key>
+{
+  /* the key must leave room for the separators and the terminating zero */
+  if (service.size() + operation.size() + bucket.size() + 3 > key_size) {
+    return {};
+  }
+  encoded_key key{};
+  auto* out = key.data();
+  for (auto part : { service, operation, bucket }) {
+    std::memcpy(out, part.data(), part.size());
+    out += part.size() + 1;
+  }
+  return key;
+}
+
+auto
+decode_key(const encoded_key& key) -> operation_metrics_key
+{
+  std::string_view service{ key.data() };
+  std::string_view operation{ service.data() + service.size() + 1 };
+  std::string_view bucket{ operation.data() + operation.size() + 1 };
+  return { std::string{ service }, std::string{ operation }, std::string{ bucket } };
+}
+
+#ifndef _WIN32
+auto
+is_process_alive(std::int64_t pid) -> bool
+{
+  return kill(static_cast<pid_t>(pid), 0) == 0 || errno != ESRCH;
+}
+
+auto
+map_segment(const std::string& name, std::uint32_t slot_count) -> bool
+{
+  const std::size_t size = header_size + sizeof(shared_slot) * slot_count;
+
+  bool created = true;
+  int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+  if (fd == -1 && errno == EEXIST) {
+    created = false;
+    fd = shm_open(name.c_str(), O_RDWR, 0600);
+  }
+  if (fd == -1) {
+    CB_LOG_WARNING("unable to open shared memory segment for metrics \"{}\": {}",
+                   name,
+                   std::strerror(errno));
+    return false;
+  }
+  if (created && ftruncate(fd, static_cast<off_t>(size)) == -1) {
+    CB_LOG_WARNING("unable to allocate {} bytes for shared memory segment for metrics \"{}\": {}",
+                   size,
+                   name,
+                   std::strerror(errno));
+    close(fd);
+    shm_unlink(name.c_str());
+    return false;
+  }
+  if (!created) {
+    /* the creator might not have allocated the segment yet */
+    struct stat info{};
+    for (int attempt = 0; attempt < 100; ++attempt) {
+      if (fstat(fd, &info) == 0 && static_cast<std::size_t>(info.st_size) >= size) {
+        break;
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    if (static_cast<std::size_t>(info.st_size) != size) {
+      CB_LOG_WARNING("shared memory segment for metrics \"{}\" has size {}, but {} is expected "
+                     "(couchbase.metrics_shm_slots has been changed?), remove it to recreate",
+                     name,
+                     info.st_size,
+                     size);
+      close(fd);
+      return false;
+    }
+  }
+
+  void* address = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (address == MAP_FAILED) {
+    CB_LOG_WARNING(
+      "unable to map shared memory segment for metrics \"{}\": {}", name, std::strerror(errno));
+    return false;
+  }
+
+  auto* header = static_cast<segment_header*>(address);
+  if (created) {
+    header->version = segment_version;
+    header->slot_count = slot_count;
+    header->slot_size = sizeof(shared_slot);
+    header->magic.store(segment_magic, std::memory_order_release);
+  } else {
+    for (int attempt = 0; attempt < 100; ++attempt) {
+      if (header->magic.load(std::memory_order_acquire) == segment_magic) {
+        break;
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    if (header->magic.load(std::memory_order_acquire) != segment_magic ||
+        header->version != segment_version || header->slot_count != slot_count ||
+        header->slot_size != sizeof(shared_slot)) {
+      CB_LOG_WARNING("shared memory segment for metrics \"{}\" has incompatible layout, remove it "
+                     "to recreate",
+                     name);
+      munmap(address, size);
+      return false;
+    }
+  }
+
+  segment.header = header;
+  segment.slots = reinterpret_cast<shared_slot*>(static_cast<char*>(address) + header_size);
+  segment.slot_count = slot_count;
+  CB_LOG_DEBUG("{} shared memory segment for metrics \"{}\", slots={}, size={}",
+               created ? "created" : "attached to",
+               name,
+               slot_count,
+               size);
+  return true;
+}
+
+void
+adopt_slot(shared_slot& slot)
+{
+  for (auto& entry : slot.entries) {
+    auto state = entry.state.load(std::memory_order_acquire);
+    if (state == entry_initializing) {
+      /* the previous owner has exited in the middle of the initialization */
+      entry.state.store(entry_free, std::memory_order_release);
+    } else if (state == entry_ready) {
+      entry.group()->abandon_in_flight();
+    }
+  }
+}
+
+auto
+claim_slot() -> shared_slot*
+{
+  const auto pid = static_cast<std::int64_t>(getpid());
+  if (segment.slot != nullptr && segment.slot_owner == pid) {
+    return segment.slot;
+  }
+  segment.slot = nullptr;
+  segment.slot_owner = pid;
+
+  for (std::uint32_t i = 0; i < segment.slot_count; ++i) {
+    auto& slot = segment.slots[i];
+    std::int64_t expected = 0;
+    if (slot.owner.compare_exchange_strong(expected, pid, std::memory_order_acq_rel) ||
+        expected == pid) {
+      segment.slot = &slot;
+      return segment.slot;
+    }
+  }
+  for (std::uint32_t i = 0; i < segment.slot_count; ++i) {
+    auto& slot = segment.slots[i];
+    auto owner = slot.owner.load(std::memory_order_acquire);
+    if (!is_process_alive(owner) &&
+        slot.owner.compare_exchange_strong(owner, pid, std::memory_order_acq_rel)) {
+      adopt_slot(slot);
+      segment.slot = &slot;
+      return segment.slot;
+    }
+  }
+  if (!segment.slots_exhausted_reported) {
+    segment.slots_exhausted_reported = true;
+    CB_LOG_WARNING("all {} slots of shared memory segment for metrics are used by running "
+                   "processes, increase couchbase.metrics_shm_slots",
+                   segment.slot_count);
+  }
+  return nullptr;
+}
+
+auto
+find_or_create_entry(shared_slot& slot, const encoded_key& key) -> operation_group*
+{
+  for (auto& entry : slot.entries) {
+    auto state = entry.state.load(std::memory_order_acquire);
+    if (state == entry_free) {
+      std::uint32_t expected = entry_free;
+      if (entry.state.compare_exchange_strong(
+            expected, entry_initializing, std::memory_order_acq_rel)) {
+        entry.key = key;
+        new (entry.storage) operation_group();
+        entry.state.store(entry_ready, std::memory_order_release);
+        return entry.group();
+      }
+      state = expected;
+    }
+    while (state == entry_initializing) {
+      std::this_thread::yield();
+      state = entry.state.load(std::memory_order_acquire);
+    }
+    if (state == entry_ready && entry.key == key) {
+      return entry.group();
+    }
+  }
+  return nullptr;
+}
+#endif
+} // namespace
+
+COUCHBASE_API
+void
+initialize_shared_metrics()
+{
+  const char* name = COUCHBASE_G(metrics_shm_name);
+  if (name == nullptr || name[0] == '\0') {
+    return;
+  }
+  auto slot_count = COUCHBASE_G(metrics_shm_slots);
+  std::call_once(segment_initialized, [name, slot_count]() {
+#ifdef _WIN32
+    (void)slot_count;
+    CB_LOG_WARNING("shared memory segment for metrics \"{}\" is not supported on this platform",
+                   name);
+#else
+    if (slot_count <= 0 || slot_count > 4096) {
+      CB_LOG_WARNING("couchbase.metrics_shm_slots must be in range [1, 4096], {} given, shared "
+                     "memory segment for metrics will not be used",
+                     slot_count);
+      return;
+    }
+    std::string segment_name{ name };
+    if (segment_name.front() != '/') {
+      segment_name.insert(0, 1, '/');
+    }
+    std::scoped_lock lock(segment_mutex);
+    map_segment(segment_name, static_cast<std::uint32_t>(slot_count));
+#endif
+  });
+}
+
+auto
+shared_operation_group(std::string_view service,
+                       std::string_view operation,
+                       std::string_view bucket) -> operation_group*
+{
+#ifdef _WIN32
+  (void)service;
+  (void)operation;
+  (void)bucket;
+  return nullptr;
+#else
+  std::scoped_lock lock(segment_mutex);
+  if (segment.header == nullptr) {
+    return nullptr;
+  }
+  auto key = encode_key(service, operation, bucket);
+  if (!key) {
+    return nullptr;
+  }
+  auto* slot = claim_slot();
+  if (slot == nullptr) {
+    return nullptr;
+  }
+  return find_or_create_entry(*slot, key.value());
+#endif
+}
+
+COUCHBASE_API
+auto
+shared_metrics_snapshots() -> std::optional<operation_snapshots>
+{
+#ifdef _WIN32
+  return {};
+#else
+  std::scoped_lock lock(segment_mutex);
+  if (segment.header == nullptr) {
+    return {};
+  }
+  std::map<operation_metrics_key, operation_group::snapshot, operation_metrics_key_less> merged{};
+  for (std::uint32_t i = 0; i < segment.slot_count; ++i) {
+    auto& slot = segment.slots[i];
+    auto owner = slot.owner.load(std::memory_order_acquire);
+    if (owner == 0) {
+      continue;
+    }
+    const bool alive = is_process_alive(owner);
+    for (auto& entry : slot.entries) {
+      if (entry.state.load(std::memory_order_acquire) != entry_ready) {
+        continue;
+      }
+      auto snapshot = entry.group()->take_snapshot();
+      if (!alive) {
+        /* operations of the exited process will never complete */
+        snapshot.in_flight = 0;
+      }
+      merged[decode_key(entry.key)].merge(snapshot);
+    }
+  }
+  operation_snapshots snapshots{};
+  snapshots.reserve(merged.size());
+  for (auto& [key, snapshot] : merged) {
+    snapshots.emplace_back(key, std::move(snapshot));
+  }
+  return snapshots;
+#endif
+}
+
+COUCHBASE_API
+auto
+shared_metrics_open_metrics() -> std::optional<std::string>
+{
+  auto snapshots = shared_metrics_snapshots();
+  if (!snapshots) {
+    return {};
+  }
+  std::string out;
+  append_open_metrics(out, snapshots.value());
+#ifndef _WIN32
+  std::scoped_lock lock(segment_mutex);
+  std::size_t processes = 0;
+  for (std::uint32_t i = 0; i < segment.slot_count; ++i) {
+    if (auto owner = segment.slots[i].owner.load(std::memory_order_acquire);
+        owner != 0 && is_process_alive(owner)) {
+      ++processes;
+    }
+  }
+  out += fmt::format("# TYPE couchbase_shared_metrics_processes gauge\n"
+                     "# HELP couchbase_shared_metrics_processes Number of the running processes "
+                     "writing into the segment.\n"
+                     "couchbase_shared_metrics_processes {}\n"
+                     "# TYPE couchbase_shared_metrics_slots gauge\n"
+                     "# HELP couchbase_shared_metrics_slots Number of the slots of the segment.\n"
+                     "couchbase_shared_metrics_slots {}\n",
+                     processes,
+                     segment.slot_count);
+#endif
+  out += "# EOF\n";
+  return out;
+}
+} // namespace couchbase::php
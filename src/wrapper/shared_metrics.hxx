@@ -0,0 +1,65 @@
+/**
+ * Copyright 2016-Present Couchbase, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "api_visibility.hxx"
+
+#include "operation_metrics.hxx"
+
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace couchbase::php
+{
+/**
+ * Maps the shared memory segment configured with couchbase.metrics_shm_name (does nothing when it
+ * is empty).
+ *
+ * The segment is split into slots, and every process writes only into the slot it has claimed, so
+ * the updates do not need any locks. The slot of the exited process keeps its counters, and it is
+ * adopted by the next process that does not find free slot, so the totals survive recycling of the
+ * workers.
+ */
+COUCHBASE_API
+void
+initialize_shared_metrics();
+
+/**
+ * Returns the group in the slot of the current process, or nullptr if the segment is not used, or
+ * it does not have space for the group.
+ */
+auto
+shared_operation_group(std::string_view service,
+                       std::string_view operation,
+                       std::string_view bucket) -> operation_group*;
+
+/**
+ * Merges the groups of all slots of the segment. Returns empty optional if the segment is not used.
+ */
+COUCHBASE_API
+auto
+shared_metrics_snapshots() -> std::optional<operation_snapshots>;
+
+/**
+ * Renders merged groups of the segment in OpenMetrics text format. Returns empty optional if the
+ * segment is not used.
+ */
+COUCHBASE_API
+auto
+shared_metrics_open_metrics() -> std::optional<std::string>;
+} // namespace couchbase::php
@@ -26,6 +26,7 @@
 
 #include <core/document_id.hxx>
 #include <core/document_id_fmt.hxx>
+#include <core/logger/logger.hxx>
 #include <core/transactions.hxx>
 #include <core/transactions/internal/exceptions_internal.hxx>
 #include <core/transactions/internal/transaction_context.hxx>
@@ -33,10 +34,16 @@
 
 #include <spdlog/fmt/bundled/core.h>
 
+#include <algorithm>
 #include <array>
 #include <chrono>
+#include <functional>
 #include <memory>
+#include <mutex>
+#include <random>
 #include <string>
+#include <thread>
+#include <vector>
 
 namespace couchbase::php
 {
@@ -166,6 +173,19 @@ failure_type_to_error_code(core::transactions::failure_type failure) -> std::err
   }
   return transactions_errc::unexpected_exception;
 }
+
+enum class staged_mutation_type {
+  insert,
+  replace,
+  remove,
+};
+
+struct staged_mutation {
+  staged_mutation_type type{};
+  core::document_id id{};
+  std::optional<core::transactions::transaction_get_result> document{};
+  codec::encoded_value content{};
+};
 } // namespace
 
 class transaction_context_resource::impl
@@ -575,6 +595,134 @@ public:
     return {};
   }
 
+  /*
+   * Issues all mutations at once, and waits until every one of them is staged, so that the latency
+   * of the batch is defined by the slowest mutation rather than by the sum of round trips.
+   */
+  [[nodiscard]] auto stage_multi(const std::vector<staged_mutation>& mutations)
+    -> std::pair<std::vector<std::optional<core::transactions::transaction_get_result>>,
+                 core_error_info>
+  {
+    if (mutations.empty()) {
+      return {};
+    }
+    struct batch_state {
+      std::mutex mutex{};
+      std::size_t pending{};
+      std::vector<std::optional<core::transactions::transaction_get_result>> results{};
+      std::exception_ptr error{};
+      std::promise<void> barrier{};
+    };
+    auto state = std::make_shared<batch_state>();
+    state->pending = mutations.size();
+    state->results.resize(mutations.size());
+    auto f = state->barrier.get_future();
+    auto on_staged = [state](std::size_t index,
+                             const std::exception_ptr& e,
+                             std::optional<core::transactions::transaction_get_result> res) {
+      bool last{ false };
+      {
+        std::scoped_lock lock(state->mutex);
+        if (e) {
+          if (!state->error) {
+            state->error = e;
+          }
+        } else {
+          state->results[index] = std::move(res);
+        }
+        last = --state->pending == 0;
+      }
+      if (last) {
+        if (state->error) {
+          return state->barrier.set_exception(state->error);
+        }
+        state->barrier.set_value();
+      }
+    };
+
+    std::size_t issued{ 0 };
+    std::exception_ptr issue_error{};
+    try {
+      for (std::size_t index = 0; index < mutations.size(); ++index) {
+        const auto& mutation = mutations[index];
+        switch (mutation.type) {
+          case staged_mutation_type::insert:
+            transaction_context_->insert(
+              mutation.id,
+              mutation.content,
+              [on_staged, index](const std::exception_ptr& e,
+                                 std::optional<core::transactions::transaction_get_result> res) {
+                on_staged(index, e, std::move(res));
+              });
+            break;
+          case staged_mutation_type::replace:
+            transaction_context_->replace(
+              mutation.document.value(),
+              mutation.content,
+              [on_staged, index](const std::exception_ptr& e,
+                                 std::optional<core::transactions::transaction_get_result> res) {
+                on_staged(index, e, std::move(res));
+              });
+            break;
+          case staged_mutation_type::remove:
+            transaction_context_->remove(mutation.document.value(),
+                                         [on_staged, index](const std::exception_ptr& e) {
+                                           on_staged(index, e, {});
+                                         });
+            break;
+        }
+        ++issued;
+      }
+    } catch (...) {
+      issue_error = std::current_exception();
+    }
+    if (issue_error) {
+      /*
+       * the mutations issued before the failure are still in flight on the attempt, and they have
+       * to complete before PHP is allowed to commit or roll back the transaction
+       */
+      bool last{ false };
+      {
+        std::scoped_lock lock(state->mutex);
+        state->pending -= mutations.size() - issued;
+        last = state->pending == 0;
+      }
+      if (last) {
+        state->barrier.set_value();
+      }
+      f.wait();
+    }
+
+    try {
+      if (issue_error) {
+        std::rethrow_exception(issue_error);
+      }
+      f.get();
+      return { std::move(state->results), {} };
+    } catch (const core::transactions::transaction_operation_failed& e) {
+      return { {},
+               { transactions_errc::operation_failed,
+                 ERROR_LOCATION,
+                 fmt::format("unable to stage multi ({}) mutations: {}, cause: {}",
+                             mutations.size(),
+                             e.what(),
+                             external_exception_to_string(e.cause())),
+                 build_error_context(e) } };
+    } catch (const std::exception& e) {
+      return { {},
+               { transactions_errc::std_exception,
+                 ERROR_LOCATION,
+                 fmt::format(
+                   "unable to stage multi ({}) mutations: {}", mutations.size(), e.what()) } };
+    } catch (...) {
+      return { {},
+               { transactions_errc::unexpected_exception,
+                 ERROR_LOCATION,
+                 fmt::format("unable to stage multi ({}) mutations: unexpected C++ exception",
+                             mutations.size()) } };
+    }
+  }
+
   [[nodiscard]] auto query(const std::string& statement,
                            const transactions::transaction_query_options& options)
     -> std::pair<std::optional<core::operations::query_response>, core_error_info>
@@ -654,6 +802,64 @@ transaction_context_resource::commit(zval* return_value) -> core_error_info
   return {};
 }
 
+namespace
+{
+/*
+ * Exponential backoff between attempts with jitter, so that the transactions that conflict on the
+ * same documents do not retry in lockstep.
+ */
+auto
+attempt_retry_delay(std::size_t attempt) -> std::chrono::microseconds
+{
+  constexpr std::chrono::microseconds min_delay{ 1'000 };
+  constexpr std::chrono::microseconds max_delay{ 100'000 };
+  std::chrono::microseconds delay{ min_delay.count() << std::min<std::size_t>(attempt, 7) };
+  delay = std::min(delay, max_delay);
+  thread_local std::mt19937_64 generator{ std::random_device{}() };
+  std::uniform_int_distribution<std::chrono::microseconds::rep> jitter(delay.count() / 2,
+                                                                       delay.count());
+  return std::chrono::microseconds{ jitter(generator) };
+}
+} // namespace
+
+COUCHBASE_API
+auto
+transaction_context_resource::run(zval* return_value, const std::function<bool()>& logic)
+  -> core_error_info
+{
+  ZVAL_NULL(return_value);
+
+  for (std::size_t attempt = 0;; ++attempt) {
+    if (auto e = impl_->new_attempt(); e.ec) {
+      return e;
+    }
+    if (!logic()) {
+      /* the logic has thrown an exception, which is left pending for the caller */
+      if (auto e = impl_->rollback(); e.ec) {
+        CB_LOG_DEBUG("unable to rollback transaction after failure of the logic: {} ({})",
+                     e.ec.message(),
+                     e.message);
+      }
+      return {};
+    }
+    auto [resp, err] = impl_->commit();
+    if (err.ec) {
+      /* errors of commit are final, retryable ones are reported as empty result */
+      return err;
+    }
+    if (resp) {
+      array_init(return_value);
+      add_assoc_stringl(
+        return_value, "transactionId", resp->transaction_id.data(), resp->transaction_id.size());
+      add_assoc_bool(return_value, "unstagingComplete", resp->unstaging_complete);
+      return {};
+    }
+    auto delay = attempt_retry_delay(attempt);
+    CB_LOG_DEBUG("retrying transaction, attempt={}, delay={}us", attempt + 1, delay.count());
+    std::this_thread::sleep_for(delay);
+  }
+}
+
 COUCHBASE_API
 auto
 transaction_context_resource::rollback() -> core_error_info
@@ -1278,17 +1484,84 @@ transaction_context_resource::remove(const zval* document) -> core_error_info
   return {};
 }
 
+COUCHBASE_API
+auto
+transaction_context_resource::stage_multi(zval* return_value, const zval* mutations)
+  -> core_error_info
+{
+  if (mutations == nullptr || Z_TYPE_P(mutations) != IS_ARRAY) {
+    return { errc::common::invalid_argument, ERROR_LOCATION, "expected mutations to be an array" };
+  }
+
+  std::vector<staged_mutation> requests{};
+  requests.reserve(zend_array_count(Z_ARRVAL_P(mutations)));
+
+  const zval* entry = nullptr;
+  ZEND_HASH_FOREACH_VAL(Z_ARRVAL_P(mutations), entry)
+  {
+    if (Z_TYPE_P(entry) != IS_ARRAY) {
+      return { errc::common::invalid_argument,
+               ERROR_LOCATION,
+               "expected that staged mutation will be an array" };
+    }
+    auto [e, type] = cb_get_string(entry, "type");
+    if (e.ec) {
+      return e;
+    }
+    staged_mutation mutation{};
+    if (type == "insert") {
+      mutation.type = staged_mutation_type::insert;
+      mutation.id = zval_to_document_id(entry);
+    } else if (type == "replace" || type == "remove") {
+      mutation.type =
+        type == "replace" ? staged_mutation_type::replace : staged_mutation_type::remove;
+      auto [doc, err] = zval_to_transaction_get_result(
+        zend_symtable_str_find(Z_ARRVAL_P(entry), ZEND_STRL("document")));
+      if (err.ec) {
+        return err;
+      }
+      mutation.document = std::move(doc);
+    } else {
+      return { errc::common::invalid_argument,
+               ERROR_LOCATION,
+               "expected type of staged mutation to be one of insert, replace or remove" };
+    }
+    if (mutation.type != staged_mutation_type::remove) {
+      if (auto err = cb_assign_binary(mutation.content.data, entry, "value"); err.ec) {
+        return err;
+      }
+      if (auto err = cb_assign_integer(mutation.content.flags, entry, "flags"); err.ec) {
+        return err;
+      }
+    }
+    requests.emplace_back(std::move(mutation));
+  }
+  ZEND_HASH_FOREACH_END();
+
+  auto [resp, err] = impl_->stage_multi(requests);
+  if (err.ec) {
+    return err;
+  }
+  array_init_size(return_value, static_cast<std::uint32_t>(resp.size()));
+  for (const auto& result : resp) {
+    zval document;
+    if (result) {
+      transaction_get_result_to_zval(&document, result.value());
+    } else {
+      ZVAL_NULL(&document);
+    }
+    add_next_index_zval(return_value, &document);
+  }
+  return {};
+}
+
 COUCHBASE_API
 auto
 transaction_context_resource::query(zval* return_value,
                                     const zend_string* statement,
                                     const zval* options) -> core_error_info
 {
-  auto [query_options, e] = zval_to_transactions_query_options(options);
-  if (e.ec) {
-    return e;
-  }
-  auto [resp, err] = impl_->query(cb_string_new(statement), query_options);
+  auto [resp, err] = execute_query(statement, options);
   if (err.ec) {
     return err;
   }
@@ -1298,6 +1571,18 @@ transaction_context_resource::query(zval* return_value,
   return {};
 }
 
+COUCHBASE_API
+auto
+transaction_context_resource::execute_query(const zend_string* statement, const zval* options)
+  -> std::pair<std::optional<core::operations::query_response>, core_error_info>
+{
+  auto [query_options, e] = zval_to_transactions_query_options(options);
+  if (e.ec) {
+    return { {}, e };
+  }
+  return impl_->query(cb_string_new(statement), query_options);
+}
+
 namespace
 {
 #define ASSIGN_DURATION_OPTION(name, setter, key, value)                                           \
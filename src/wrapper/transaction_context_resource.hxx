@@ -22,13 +22,21 @@
 
 #include <Zend/zend_API.h>
 
+#include <functional>
 #include <memory>
+#include <optional>
+#include <utility>
 
 namespace couchbase::transactions
 {
 class transaction_options;
 } // namespace couchbase::transactions
 
+namespace couchbase::core::operations
+{
+struct query_response;
+} // namespace couchbase::core::operations
+
 namespace couchbase::php
 {
 class transaction_context_resource
@@ -45,6 +53,13 @@ public:
   COUCHBASE_API
   auto rollback() -> core_error_info;
 
+  /**
+   * Runs attempts of the transaction until it commits or fails permanently. The logic is invoked
+   * once per attempt, and returns false if it has thrown an exception.
+   */
+  COUCHBASE_API
+  auto run(zval* return_value, const std::function<bool()>& logic) -> core_error_info;
+
   COUCHBASE_API
   auto get(zval* return_value,
            const zend_string* bucket,
@@ -82,10 +97,17 @@ public:
   COUCHBASE_API
   auto remove(const zval* document) -> core_error_info;
 
+  COUCHBASE_API
+  auto stage_multi(zval* return_value, const zval* mutations) -> core_error_info;
+
   COUCHBASE_API
   auto query(zval* return_value, const zend_string* statement, const zval* options)
     -> core_error_info;
 
+  COUCHBASE_API
+  auto execute_query(const zend_string* statement, const zval* options)
+    -> std::pair<std::optional<couchbase::core::operations::query_response>, core_error_info>;
+
 private:
   class impl;
 
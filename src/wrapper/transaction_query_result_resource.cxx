@@ -0,0 +1,153 @@
+/**
+ * Copyright 2022-Present Couchbase, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "wrapper.hxx"
+
+#include "common.hxx"
+#include "conversion_utilities.hxx"
+#include "transaction_context_resource.hxx"
+#include "transaction_query_result_resource.hxx"
+
+#include <core/operations/document_query.hxx>
+
+#include <algorithm>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace couchbase::php
+{
+namespace
+{
+int transaction_query_result_destructor_id_{ 0 };
+} // namespace
+
+void
+set_transaction_query_result_destructor_id(int id)
+{
+  transaction_query_result_destructor_id_ = id;
+}
+
+auto
+get_transaction_query_result_destructor_id() -> int
+{
+  return transaction_query_result_destructor_id_;
+}
+
+class transaction_query_result_resource::impl
+{
+public:
+  /*
+   * The core delivers the query response only when it is complete, so the rows are taken over
+   * without copying, and released one by one as they are returned to PHP.
+   */
+  explicit impl(core::operations::query_response&& resp)
+    : rows_{ std::move(resp.rows) }
+    , response_{ std::move(resp) }
+  {
+    response_.rows.clear();
+  }
+
+  void next_batch(std::vector<std::string>& rows, std::size_t limit)
+  {
+    auto count = std::min(limit, rows_.size() - next_row_);
+    rows.reserve(count);
+    for (std::size_t i = 0; i < count; ++i) {
+      rows.emplace_back(std::move(rows_[next_row_++]));
+    }
+    if (next_row_ == rows_.size()) {
+      rows_ = {};
+      next_row_ = 0;
+    }
+  }
+
+  [[nodiscard]] auto response() const -> const core::operations::query_response&
+  {
+    return response_;
+  }
+
+private:
+  std::vector<std::string> rows_;
+  std::size_t next_row_{ 0 };
+  core::operations::query_response response_;
+};
+
+COUCHBASE_API
+transaction_query_result_resource::transaction_query_result_resource(
+  core::operations::query_response&& resp)
+  : impl_{ std::make_unique<impl>(std::move(resp)) }
+{
+}
+
+COUCHBASE_API
+transaction_query_result_resource::~transaction_query_result_resource() = default;
+
+COUCHBASE_API
+auto
+transaction_query_result_resource::next_batch(zval* return_value, zend_long limit)
+  -> core_error_info
+{
+  if (limit <= 0) {
+    return { errc::common::invalid_argument,
+             ERROR_LOCATION,
+             "expected limit for query batch to be a positive number" };
+  }
+  std::vector<std::string> rows;
+  impl_->next_batch(rows, static_cast<std::size_t>(limit));
+  if (rows.empty()) {
+    return {};
+  }
+  array_init_size(return_value, static_cast<uint32_t>(rows.size()));
+  for (const auto& row : rows) {
+    add_next_index_stringl(return_value, row.data(), row.size());
+  }
+  return {};
+}
+
+COUCHBASE_API
+void
+transaction_query_result_resource::meta_data(zval* return_value)
+{
+  query_response_to_zval(return_value, impl_->response());
+}
+
+COUCHBASE_API
+auto
+create_transaction_query_result_resource(transaction_context_resource* context,
+                                         const zend_string* statement,
+                                         const zval* options)
+  -> std::pair<zend_resource*, core_error_info>
+{
+  auto [resp, err] = context->execute_query(statement, options);
+  if (err.ec) {
+    return { nullptr, err };
+  }
+  auto* handle = new transaction_query_result_resource(
+    std::move(resp).value_or(core::operations::query_response{}));
+  return { zend_register_resource(handle, transaction_query_result_destructor_id_), {} };
+}
+
+COUCHBASE_API
+void
+destroy_transaction_query_result_resource(zend_resource* res)
+{
+  if (res->type == transaction_query_result_destructor_id_ && res->ptr != nullptr) {
+    auto* handle = static_cast<transaction_query_result_resource*>(res->ptr);
+    res->ptr = nullptr;
+    delete handle;
+  }
+}
+} // namespace couchbase::php
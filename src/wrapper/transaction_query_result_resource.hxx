@@ -0,0 +1,77 @@
+/**
+ * Copyright 2022-Present Couchbase, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "api_visibility.hxx"
+
+#include "core_error_info.hxx"
+
+#include <Zend/zend_API.h>
+
+#include <memory>
+#include <utility>
+
+namespace couchbase::core::operations
+{
+struct query_response;
+} // namespace couchbase::core::operations
+
+namespace couchbase::php
+{
+class transaction_context_resource;
+
+/**
+ * Rows of the query executed in the context of the transaction. The rows are handed to PHP in
+ * batches, so that the application never holds the decoded result set as a whole. The raw rows are
+ * not bounded: the core receives the complete response before the first batch is available.
+ */
+class transaction_query_result_resource
+{
+public:
+  COUCHBASE_API
+  explicit transaction_query_result_resource(couchbase::core::operations::query_response&& resp);
+
+  COUCHBASE_API
+  ~transaction_query_result_resource();
+
+  COUCHBASE_API
+  auto next_batch(zval* return_value, zend_long limit) -> core_error_info;
+
+  COUCHBASE_API
+  void meta_data(zval* return_value);
+
+private:
+  class impl;
+
+  std::unique_ptr<impl> impl_;
+};
+
+COUCHBASE_API auto
+create_transaction_query_result_resource(transaction_context_resource* context,
+                                         const zend_string* statement,
+                                         const zval* options)
+  -> std::pair<zend_resource*, core_error_info>;
+
+COUCHBASE_API void
+destroy_transaction_query_result_resource(zend_resource* res);
+
+COUCHBASE_API void
+set_transaction_query_result_destructor_id(int id);
+
+COUCHBASE_API auto
+get_transaction_query_result_destructor_id() -> int;
+} // namespace couchbase::php
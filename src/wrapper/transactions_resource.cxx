@@ -23,6 +23,7 @@
 
 #include <spdlog/fmt/bundled/core.h>
 
+#include <string>
 #include <thread>
 
 namespace couchbase::php
@@ -49,9 +50,11 @@ get_transactions_destructor_id() -> int
 class transactions_resource::impl : public std::enable_shared_from_this<transactions_resource::impl>
 {
 public:
-  impl(connection_handle* connection, const couchbase::transactions::transactions_config& config)
+  impl(connection_handle* connection,
+       const std::string& config_key,
+       const couchbase::transactions::transactions_config& config)
     : cluster_{ connection->cluster() }
-    , transactions_(cluster_, config)
+    , transactions_{ connection->transactions(config_key, config) }
   {
   }
 
@@ -67,24 +70,25 @@ public:
 
   [[nodiscard]] auto transactions() -> couchbase::core::transactions::transactions&
   {
-    return transactions_;
+    return *transactions_;
   }
 
   void notify_fork(couchbase::fork_event event)
   {
-    transactions_.notify_fork(event);
+    transactions_->notify_fork(event);
   }
 
 private:
   couchbase::core::cluster cluster_;
-  couchbase::core::transactions::transactions transactions_;
+  std::shared_ptr<couchbase::core::transactions::transactions> transactions_;
 };
 
 COUCHBASE_API
 transactions_resource::transactions_resource(
   connection_handle* connection,
+  const std::string& config_key,
   const couchbase::transactions::transactions_config& configuration)
-  : impl_{ std::make_shared<transactions_resource::impl>(connection, configuration) }
+  : impl_{ std::make_shared<transactions_resource::impl>(connection, config_key, configuration) }
 {
 }
 
@@ -164,6 +168,60 @@ namespace
     (field).assign(Z_STRVAL_P(value), Z_STRLEN_P(value));                                          \
   }
 
+/*
+ * Builds the key that identifies equal transactions configurations.
+ */
+void
+append_options_fingerprint(std::string& out, const zval* value)
+{
+  if (value == nullptr) {
+    out += 'n';
+    return;
+  }
+  switch (Z_TYPE_P(value)) {
+    case IS_NULL:
+      out += 'n';
+      break;
+    case IS_TRUE:
+      out += 't';
+      break;
+    case IS_FALSE:
+      out += 'f';
+      break;
+    case IS_LONG:
+      out += fmt::format("i{};", Z_LVAL_P(value));
+      break;
+    case IS_DOUBLE:
+      out += fmt::format("d{};", Z_DVAL_P(value));
+      break;
+    case IS_STRING:
+      out += fmt::format("s{}:", Z_STRLEN_P(value));
+      out.append(Z_STRVAL_P(value), Z_STRLEN_P(value));
+      break;
+    case IS_ARRAY: {
+      out += 'a';
+      zend_ulong index = 0;
+      const zend_string* key = nullptr;
+      const zval* item = nullptr;
+      ZEND_HASH_FOREACH_KEY_VAL(Z_ARRVAL_P(value), index, key, item)
+      {
+        if (key != nullptr) {
+          out += fmt::format("k{}:", ZSTR_LEN(key));
+          out.append(ZSTR_VAL(key), ZSTR_LEN(key));
+        } else {
+          out += fmt::format("k{};", index);
+        }
+        append_options_fingerprint(out, item);
+      }
+      ZEND_HASH_FOREACH_END();
+      out += ';';
+    } break;
+    default:
+      out += '?';
+      break;
+  }
+}
+
 auto
 apply_options(couchbase::transactions::transactions_config& config, zval* options)
   -> core_error_info
@@ -321,7 +379,9 @@ create_transactions_resource(connection_handle* connection, zval* options)
       return { nullptr, e };
     }
   }
-  auto* handle = new transactions_resource(connection, config);
+  std::string config_key{};
+  append_options_fingerprint(config_key, options);
+  auto* handle = new transactions_resource(connection, config_key, config);
   return { zend_register_resource(handle, transactions_destructor_id_), {} };
 }
 
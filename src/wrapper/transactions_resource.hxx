@@ -23,6 +23,7 @@
 #include <Zend/zend_API.h>
 
 #include <memory>
+#include <string>
 
 namespace couchbase
 {
@@ -43,6 +44,7 @@ class transactions_resource
 public:
   COUCHBASE_API
   transactions_resource(connection_handle* connection,
+                        const std::string& config_key,
                         const couchbase::transactions::transactions_config& configuration);
 
   COUCHBASE_API
@@ -0,0 +1,170 @@
+<?php
+
+/**
+ * Copyright 2014-Present Couchbase, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * Micro-benchmarks of the hot paths between PHP and the extension.
+ *
+ * Like the tests, the benchmarks run against the CAVES mock cluster (build/gocaves, downloaded by
+ * bin/test.rb) unless TEST_CONNECTION_STRING is set, so the client-side costs (marshalling of the
+ * options and results, creation of the exceptions, etc.) can be compared without a real cluster:
+ *
+ *     php -d extension=modules/couchbase.so tests/Benchmarks/run.php [--iterations=N] [--json] [name...]
+ *
+ * Every benchmark reports throughput, p50/p99 latency of single operation, and the peak of the memory
+ * allocated by PHP during the operation (requires PHP 8.2 for memory_reset_peak_usage(), the
+ * extension and the core allocate outside of the Zend memory manager, and are not included).
+ */
+
+declare(strict_types=1);
+
+include_once __DIR__ . "/../../Couchbase/autoload.php";
+include_once __DIR__ . "/../Helpers/TestEnvironment.php";
+
+use Couchbase\Cluster;
+use Couchbase\ClusterInterface;
+use Couchbase\ClusterOptions;
+use Couchbase\CollectionInterface;
+use Couchbase\Exception\DocumentNotFoundException;
+use Couchbase\GetOptions;
+use Helpers\TestEnvironment;
+
+function measure(int $iterations, callable $operation): array
+{
+    /* warm up connections and caches of the interpreter */
+    for ($i = 0; $i < min($iterations, 100); $i++) {
+        $operation($i);
+    }
+
+    $trackMemory = function_exists("memory_reset_peak_usage");
+    $latencies = [];
+    $allocated = 0;
+    $started = hrtime(true);
+    for ($i = 0; $i < $iterations; $i++) {
+        if ($trackMemory) {
+            memory_reset_peak_usage();
+        }
+        $memoryBefore = memory_get_usage();
+        $operationStarted = hrtime(true);
+        $operation($i);
+        $latencies[] = hrtime(true) - $operationStarted;
+        $allocated += memory_get_peak_usage() - $memoryBefore;
+    }
+    $elapsed = hrtime(true) - $started;
+
+    sort($latencies);
+    return [
+        "iterations" => $iterations,
+        "opsPerSecond" => $iterations / ($elapsed / 1e9),
+        "p50Microseconds" => $latencies[intdiv($iterations * 50, 100)] / 1e3,
+        "p99Microseconds" => $latencies[min($iterations - 1, intdiv($iterations * 99, 100))] / 1e3,
+        "peakBytesPerOperation" => $trackMemory ? intdiv($allocated, $iterations) : null,
+    ];
+}
+
+function benchmarks(TestEnvironment $env, CollectionInterface $collection, ClusterInterface $cluster): array
+{
+    $prefix = TestEnvironment::randomId();
+    $document = [
+        "name" => "benchmark",
+        "tags" => ["php", "couchbase", "benchmark"],
+        "nested" => ["counter" => 42, "enabled" => true, "ratio" => 0.5],
+    ];
+    $batch = [];
+    for ($i = 0; $i < 16; $i++) {
+        $batch[] = "$prefix-multi-$i";
+        $collection->upsert("$prefix-multi-$i", $document);
+    }
+    $collection->upsert("$prefix-get", $document);
+
+    return [
+        "documentUpsert" => function (int $i) use ($collection, $prefix, $document) {
+            $collection->upsert("$prefix-upsert-" . ($i % 1024), $document);
+        },
+        "documentGet" => function () use ($collection, $prefix) {
+            $collection->get("$prefix-get");
+        },
+        "documentGet (miss, exception)" => function (int $i) use ($collection, $prefix) {
+            try {
+                $collection->get("$prefix-missing-$i");
+            } catch (DocumentNotFoundException $e) {
+                /* expected */
+            }
+        },
+        "documentGet (miss, returnNullOnMissing)" => function (int $i) use ($collection, $prefix) {
+            $collection->get("$prefix-missing-$i", GetOptions::build()->returnNullOnMissing(true));
+        },
+        "documentGetMulti (16 documents)" => function () use ($collection, $batch) {
+            $collection->getMulti($batch);
+        },
+        /* CAVES does not implement the query service */
+        "query" => $env->useCaves() ? null : function () use ($cluster) {
+            $cluster->query('SELECT "benchmark" AS name');
+        },
+    ];
+}
+
+$iterations = 10_000;
+$json = false;
+$filters = [];
+foreach (array_slice($argv, 1) as $arg) {
+    if (str_starts_with($arg, "--iterations=")) {
+        $iterations = max(1, (int)substr($arg, strlen("--iterations=")));
+    } elseif ($arg == "--json") {
+        $json = true;
+    } else {
+        $filters[] = $arg;
+    }
+}
+
+$env = new TestEnvironment();
+$env->start();
+try {
+    $options = new ClusterOptions();
+    $options->authenticator($env->buildPasswordAuthenticator());
+    $cluster = Cluster::connect($env->connectionString(), $options);
+    $collection = $cluster->bucket($env->bucketName())->defaultCollection();
+
+    $results = [];
+    foreach (benchmarks($env, $collection, $cluster) as $name => $operation) {
+        if ($filters && !array_filter($filters, fn($filter) => str_contains($name, $filter))) {
+            continue;
+        }
+        if (is_null($operation)) {
+            if (!$json) {
+                fprintf(STDERR, "%s: skipped, not supported by the mock cluster\n", $name);
+            }
+            continue;
+        }
+        $results[$name] = measure($iterations, $operation);
+        if (!$json) {
+            printf(
+                "%-40s %10.0f ops/s  p50 %8.1f us  p99 %8.1f us  %6s peak bytes/op\n",
+                $name,
+                $results[$name]["opsPerSecond"],
+                $results[$name]["p50Microseconds"],
+                $results[$name]["p99Microseconds"],
+                $results[$name]["peakBytesPerOperation"] ?? "n/a"
+            );
+        }
+    }
+    if ($json) {
+        echo json_encode($results, JSON_PRETTY_PRINT), "\n";
+    }
+} finally {
+    $env->stop();
+}
@@ -0,0 +1,41 @@
+<?php
+
+/**
+ * Copyright 2014-Present Couchbase, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+declare(strict_types=1);
+
+use Couchbase\Exception\DocumentNotFoundException;
+
+include_once __DIR__ . "/Helpers/CouchbaseTestCase.php";
+
+class ExceptionContextTest extends Helpers\CouchbaseTestCase
+{
+    public function testDocumentNotFoundExceptionHasContext()
+    {
+        $collection = $this->defaultCollection();
+        $id = $this->uniqueId("foo");
+        try {
+            $collection->get($id);
+            $this->fail("expected DocumentNotFoundException");
+        } catch (DocumentNotFoundException $ex) {
+            $context = $ex->getContext();
+            $this->assertEquals($id, $context["id"]);
+            $this->assertEquals(self::env()->bucketName(), $context["bucketName"]);
+            $this->assertSame($context, $ex->getContext());
+        }
+    }
+}
@@ -49,4 +49,122 @@ class ForkTest extends Helpers\CouchbaseTestCase
             $this->assertEquals($cas, $res->cas());
         }
     }
+
+    public function testForkTemplate()
+    {
+        $this->skipIfProtostellar();
+        if (!extension_loaded("pcntl")) {
+            $this->markTestSkipped("The 'pcntl' extension require to test Cluster::prepareForkTemplate helper");
+        }
+        $id = $this->uniqueId();
+        $collection = $this->cluster->bucket(self::env()->bucketName())->defaultCollection();
+        $res = $collection->upsert($id, ["answer" => 42]);
+        $cas = $res->cas();
+        $this->assertNotNull($cas);
+
+        $this->cluster->prepareForkTemplate([self::env()->bucketName()]);
+
+        $status = $this->runInChild(
+            function () use ($collection, $id, $cas) {
+                $res = $collection->get($id);
+                $this->assertEquals($cas, $res->cas());
+            }
+        );
+        $this->assertEquals(0, $status);
+
+        $res = $collection->get($id);
+        $this->assertEquals($cas, $res->cas());
+    }
+
+    public function testChildWritesMetricsIntoItsOwnSharedSlot()
+    {
+        $this->skipIfProtostellar();
+        if (!extension_loaded("pcntl")) {
+            $this->markTestSkipped("The 'pcntl' extension require to test Cluster::notifyFork helper");
+        }
+        if (!ini_get("couchbase.metrics_shm_name")) {
+            $this->markTestSkipped("The shared memory segment for metrics is not configured");
+        }
+        $id = $this->uniqueId();
+        $collection = $this->defaultCollection();
+        $collection->upsert($id, ["answer" => 42]);
+        $processes = self::sharedMetricsProcesses();
+
+        $status = $this->runInChild(
+            function () use ($collection, $id, $processes) {
+                $collection->get($id);
+                $this->assertEquals($processes + 1, self::sharedMetricsProcesses());
+            }
+        );
+        $this->assertEquals(0, $status);
+    }
+
+    public function testForkHandlersResumeConnectionsAutomatically()
+    {
+        $this->skipIfProtostellar();
+        if (!extension_loaded("pcntl")) {
+            $this->markTestSkipped("The 'pcntl' extension require to test fork handlers");
+        }
+        if (!ini_get("couchbase.fork_handlers")) {
+            $this->markTestSkipped("The fork handlers are disabled, set couchbase.fork_handlers=1 in php.ini");
+        }
+        $id = $this->uniqueId();
+        $collection = $this->defaultCollection();
+        $res = $collection->upsert($id, ["answer" => 42]);
+        $cas = $res->cas();
+        $this->assertNotNull($cas);
+
+        $status = $this->runInChild(
+            function () use ($collection, $id, $cas) {
+                $res = $collection->get($id);
+                $this->assertEquals($cas, $res->cas());
+            },
+            false
+        );
+        $this->assertEquals(0, $status);
+
+        $res = $collection->get($id);
+        $this->assertEquals($cas, $res->cas());
+    }
+
+    private static function sharedMetricsProcesses(): int
+    {
+        preg_match('/^couchbase_shared_metrics_processes (\d+)$/m', Cluster::sharedMetricsOpenMetrics(), $matches);
+        return (int)$matches[1];
+    }
+
+    /**
+     * Runs the callback in the child process and returns its exit status. The parent does not resume
+     * the connection until the child exits, so they never read responses from the same sockets.
+     * When $notifyFork is false, the fork handlers (couchbase.fork_handlers=1) prepare and resume the
+     * library around fork() instead, and the parent resumes immediately.
+     */
+    private function runInChild(callable $callback, bool $notifyFork = true): int
+    {
+        if ($notifyFork) {
+            Cluster::notifyFork(ForkEvent::PREPARE);
+        }
+        $pid = pcntl_fork();
+        if ($pid == 0) {
+            if ($notifyFork) {
+                Cluster::notifyFork(ForkEvent::CHILD);
+            }
+            try {
+                $callback();
+                $status = 0;
+            } catch (Throwable $e) {
+                fprintf(STDERR, "%s\n", $e);
+                $status = 1;
+            }
+            exit($status);
+        }
+        if ($pid > 0) {
+            pcntl_waitpid($pid, $status);
+        }
+        if ($notifyFork) {
+            Cluster::notifyFork(ForkEvent::PARENT);
+        }
+        $this->assertGreaterThan(0, $pid, "unable to fork");
+        return pcntl_wexitstatus($status);
+    }
 }
@@ -26,6 +26,7 @@ include_once __DIR__ . "/Tracing/TestSpan.php";
 include_once __DIR__ . "/Tracing/ParentSpanRequirement.php";
 include_once __DIR__ . "/Metrics/TestMeter.php";
 include_once __DIR__ . "/Metrics/TestValueRecorder.php";
+include_once __DIR__ . "/Metrics/CountingLoggingMeter.php";
 
 use Couchbase\ClusterInterface;
 use Couchbase\ClusterOptions;
@@ -0,0 +1,52 @@
+<?php
+
+/**
+ * Copyright 2014-Present Couchbase, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+declare(strict_types=1);
+
+namespace Helpers\Metrics;
+
+use Couchbase\LoggingMeter;
+use Couchbase\NoopValueRecorder;
+use Couchbase\Observability\ObservabilityConstants;
+use Couchbase\ValueRecorder;
+
+/**
+ * LoggingMeter that counts the durations recorded from PHP instead of passing them to the core.
+ */
+class CountingLoggingMeter extends LoggingMeter
+{
+    private int $recordedOperations = 0;
+
+    public function __construct()
+    {
+        parent::__construct(null);
+    }
+
+    public function valueRecorder(string $name, array $tags): ValueRecorder
+    {
+        if ($name == ObservabilityConstants::METER_NAME_OPERATION_DURATION) {
+            $this->recordedOperations++;
+        }
+        return new NoopValueRecorder();
+    }
+
+    public function recordedOperations(): int
+    {
+        return $this->recordedOperations;
+    }
+}
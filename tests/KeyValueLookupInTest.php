@@ -34,6 +34,17 @@ include_once __DIR__ . "/Helpers/CouchbaseTestCase.php";
 
 class KeyValueLookupInTest extends Helpers\CouchbaseTestCase
 {
+    public function testLookupInReturnsNullOnMissing()
+    {
+        $collection = $this->defaultCollection();
+        $result = $collection->lookupIn(
+            $this->uniqueId("foo"),
+            [new LookupGetSpec("foo")],
+            LookupInOptions::build()->returnNullOnMissing(true)
+        );
+        $this->assertNull($result);
+    }
+
     public function testSubdocumenLookupCanFetchExpiry()
     {
         $id = $this->uniqueId("foo");
@@ -0,0 +1,43 @@
+<?php
+
+/**
+ * Copyright 2014-Present Couchbase, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+declare(strict_types=1);
+
+use Couchbase\GetOptions;
+
+include_once __DIR__ . "/Helpers/CouchbaseTestCase.php";
+
+class KeyValueReturnNullOnMissingTest extends Helpers\CouchbaseTestCase
+{
+    public function testGetReturnsNullOnMissing()
+    {
+        $collection = $this->defaultCollection();
+        $this->assertNull($collection->get($this->uniqueId("foo"), GetOptions::build()->returnNullOnMissing(true)));
+    }
+
+    public function testGetMultiReturnsNullForMissingDocuments()
+    {
+        $collection = $this->defaultCollection();
+        $id = $this->uniqueId();
+        $collection->upsert($id, ["answer" => 42]);
+        $results = $collection->getMulti([$id, $this->uniqueId("foo")], GetOptions::build()->returnNullOnMissing(true));
+        $this->assertCount(2, $results);
+        $this->assertEquals(["answer" => 42], $results[0]->content());
+        $this->assertNull($results[1]);
+    }
+}
@@ -42,6 +42,7 @@ class KeyValueScanTest extends Helpers\CouchbaseTestCase
     private array $batchByteLimitValues = [0, 1, 25, 100];
     private array $batchItemLimitValues = [0, 1, 25, 100];
     private array $concurrencyValues = [1, 2, 4, 8, 32, 128];
+    private array $prefetchSizeValues = [1, 7, 1024];
     private CollectionManager $manager;
     private CollectionSpec $collectionSpec;
 
@@ -81,7 +82,7 @@ class KeyValueScanTest extends Helpers\CouchbaseTestCase
         for ($i = 0; $i < 100; $i++) {
             $s = str_pad((string)$i, 2, "0", STR_PAD_LEFT);
             $id = $this->sharedPrefix . "-" . $s;
-            $this->collection->upsert($id, ['num' => $s], $options);
+            $this->collection->upsert($id, ['num' => $s, 'extra' => "extra-$s"], $options);
             $this->testIds[] = $id;
         }
     }
@@ -362,6 +363,43 @@ class KeyValueScanTest extends Helpers\CouchbaseTestCase
         $this->validateScan($results, $expectedIds);
     }
 
+    public function testRangeScanWithProjection()
+    {
+        $this->skipIfCaves();
+        $this->skipIfUnsupported($this->version()->supportsRangeScan());
+
+        $expectedIds = range("10", "29");
+        $expectedIds = array_map(
+            function ($val) {
+                return $this->sharedPrefix . "-" . $val;
+            },
+            $expectedIds
+        );
+
+        $results = $this->collection->scan(
+            new RangeScan(
+                ScanTerm::build($this->sharedPrefix . "-10"),
+                ScanTerm::build($this->sharedPrefix . "-29")
+            ),
+            ScanOptions::build()->project(["num"])
+        );
+        $this->validateScan($results, $expectedIds);
+        foreach ($results as $result) {
+            $this->assertEquals(["num"], array_keys($result->content()));
+        }
+
+        $results = $this->collection->scan(
+            new RangeScan(
+                ScanTerm::build($this->sharedPrefix . "-10"),
+                ScanTerm::build($this->sharedPrefix . "-29")
+            ),
+            ScanOptions::build()->project(["missing.path"])
+        );
+        foreach ($results as $result) {
+            $this->assertEmpty($result->content());
+        }
+    }
+
     public function testPrefixScanIdsOnly()
     {
         $this->skipIfCaves();
@@ -533,6 +571,105 @@ class KeyValueScanTest extends Helpers\CouchbaseTestCase
         }
     }
 
+    public function testRangeScanPrefetchSize()
+    {
+        $this->skipIfCaves();
+        $this->skipIfUnsupported($this->version()->supportsRangeScan());
+
+        $expectedIds = range("10", "29");
+        $expectedIds = array_map(
+            function ($val) {
+                return $this->sharedPrefix . "-" . $val;
+            },
+            $expectedIds
+        );
+
+        foreach ($this->prefetchSizeValues as $value) {
+            $results = $this->collection->scan(
+                new RangeScan(
+                    ScanTerm::build($this->sharedPrefix . "-10"),
+                    ScanTerm::build($this->sharedPrefix . "-29")
+                ),
+                ScanOptions::build()->prefetchSize($value)
+            );
+            $this->validateScan($results, $expectedIds);
+        }
+    }
+
+    public function testRangeScanPartitions()
+    {
+        $this->skipIfCaves();
+        $this->skipIfUnsupported($this->version()->supportsRangeScan());
+
+        $expectedIds = range("10", "29");
+        $expectedIds = array_map(
+            function ($val) {
+                return $this->sharedPrefix . "-" . $val;
+            },
+            $expectedIds
+        );
+
+        $partitionCount = 3;
+        $testIdsReturned = [];
+        for ($index = 0; $index < $partitionCount; $index++) {
+            $results = $this->collection->scan(
+                new RangeScan(
+                    ScanTerm::build($this->sharedPrefix . "-10"),
+                    ScanTerm::build($this->sharedPrefix . "-29")
+                ),
+                ScanOptions::build()->partition($index, $partitionCount)->concurrency(4)
+            );
+            foreach ($results as $result) {
+                $testIdsReturned[] = $result->id();
+                $this->assertNotNull($result->cas());
+            }
+        }
+        $this->assertEqualsCanonicalizing($expectedIds, $testIdsReturned);
+    }
+
+    public function testRangeScanResumeFromCheckpoint()
+    {
+        $this->skipIfCaves();
+        $this->skipIfUnsupported($this->version()->supportsRangeScan());
+
+        $expectedIds = range("10", "29");
+        $expectedIds = array_map(
+            function ($val) {
+                return $this->sharedPrefix . "-" . $val;
+            },
+            $expectedIds
+        );
+        $scanType = new RangeScan(
+            ScanTerm::build($this->sharedPrefix . "-10"),
+            ScanTerm::build($this->sharedPrefix . "-29")
+        );
+
+        $testIdsReturned = [];
+        $results = $this->collection->scan($scanType, ScanOptions::build()->resumable(true));
+        foreach ($results as $result) {
+            $testIdsReturned[] = $result->id();
+            if (count($testIdsReturned) == 7) {
+                break;
+            }
+        }
+        $checkpoint = unserialize(serialize($results->checkpoint()));
+        $this->assertNotEmpty($checkpoint["vbuckets"]);
+        foreach ($checkpoint["vbuckets"] as $entry) {
+            if (isset($entry["vbucketUuid"])) {
+                /* unsigned 64-bit values are encoded as hex strings */
+                $this->assertMatchesRegularExpression('/^[0-9a-f]+$/', $entry["vbucketUuid"]);
+                $this->assertMatchesRegularExpression('/^[0-9a-f]+$/', $entry["sequenceNumber"]);
+            }
+        }
+
+        $results = $this->collection->scan($scanType, ScanOptions::build()->resumeFrom($checkpoint));
+        foreach ($results as $result) {
+            $testIdsReturned[] = $result->id();
+        }
+        $this->assertEmpty($results->checkpoint()["vbuckets"]);
+        $this->assertEqualsCanonicalizing($expectedIds, $testIdsReturned);
+    }
+
     public function testRangeScanBatchItemLimit()
     {
         $this->skipIfCaves();
@@ -694,6 +831,24 @@ class KeyValueScanTest extends Helpers\CouchbaseTestCase
         );
     }
 
+    public function testRangeScanNonPositivePrefetchSize()
+    {
+        $this->expectException(\Couchbase\Exception\InvalidArgumentException::class);
+        $this->collection->scan(
+            RangeScan::build(),
+            ScanOptions::build()->prefetchSize(0)
+        );
+    }
+
+    public function testRangeScanInvalidPartition()
+    {
+        $this->expectException(\Couchbase\Exception\InvalidArgumentException::class);
+        $this->collection->scan(
+            RangeScan::build(),
+            ScanOptions::build()->partition(3, 3)
+        );
+    }
+
     public function testRangeScanFeatureNotAvailable()
     {
         $this->skipIfUnsupported(!$this->version()->supportsRangeScan());
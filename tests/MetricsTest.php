@@ -0,0 +1,95 @@
+<?php
+
+/**
+ * Copyright 2014-Present Couchbase, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+declare(strict_types=1);
+
+use Couchbase\Cluster;
+use Couchbase\ClusterInterface;
+
+include_once __DIR__ . "/Helpers/CouchbaseTestCase.php";
+
+class MetricsTest extends Helpers\CouchbaseTestCase
+{
+    public function testGetIsRecordedInMetricsSnapshot()
+    {
+        $this->skipIfProtostellar();
+        $cluster = $this->clusterWithRecordedGet();
+
+        $entries = self::documentGetEntries($cluster->metricsSnapshot());
+        $this->assertCount(1, $entries);
+        $this->assertEquals("kv", $entries[0]["service"]);
+        $this->assertGreaterThanOrEqual(1, $entries[0]["count"]);
+        $this->assertLessThanOrEqual($entries[0]["maxUs"], $entries[0]["percentilesUs"]["50"]);
+        $this->assertNotEmpty($entries[0]["bucketsUs"]);
+    }
+
+    public function testGetIsExportedInOpenMetricsFormat()
+    {
+        $this->skipIfProtostellar();
+        $cluster = $this->clusterWithRecordedGet();
+
+        $text = $cluster->metricsOpenMetrics();
+        $labels = sprintf('service="kv",operation="document_get",bucket="%s"', self::env()->bucketName());
+        $this->assertStringContainsString("# TYPE couchbase_operation_duration_seconds histogram\n", $text);
+        $this->assertStringContainsString("couchbase_operation_duration_seconds_bucket{" . $labels . ',le="+Inf"}', $text);
+        $this->assertStringContainsString("couchbase_operations_in_flight{" . $labels . "} 0\n", $text);
+        $this->assertMatchesRegularExpression('/^couchbase_connections\{service="kv",node="[^"]+",state="connected"\} \d+$/m', $text);
+        $this->assertStringEndsWith("# EOF\n", $text);
+    }
+
+    public function testGetIsMergedIntoSharedMetrics()
+    {
+        if (!ini_get("couchbase.metrics_shm_name")) {
+            $this->assertNull(Cluster::sharedMetricsSnapshot());
+            $this->assertNull(Cluster::sharedMetricsOpenMetrics());
+            return;
+        }
+        $this->skipIfProtostellar();
+        $this->clusterWithRecordedGet();
+
+        $entries = self::documentGetEntries(Cluster::sharedMetricsSnapshot());
+        $this->assertCount(1, $entries);
+        $this->assertGreaterThanOrEqual(1, $entries[0]["count"]);
+        $this->assertStringEndsWith("# EOF\n", Cluster::sharedMetricsOpenMetrics());
+    }
+
+    /**
+     * Connects to the cluster and executes one get, so that its metrics have the entry of "document_get"
+     */
+    private function clusterWithRecordedGet(): ClusterInterface
+    {
+        $cluster = $this->connectCluster();
+        $collection = $cluster->bucket(self::env()->bucketName())->defaultCollection();
+        $id = $this->uniqueId();
+        $collection->upsert($id, ["answer" => 42]);
+        $collection->get($id);
+        return $cluster;
+    }
+
+    private static function documentGetEntries(array $snapshot): array
+    {
+        return array_values(
+            array_filter(
+                $snapshot,
+                function (array $entry) {
+                    return $entry["operation"] == "document_get" && $entry["bucket"] == self::env()->bucketName();
+                }
+            )
+        );
+    }
+}
@@ -35,13 +35,14 @@ class ObservabilityContextTest extends Helpers\CouchbaseObservabilityTestCase
             function (ObservabilityHandler $handler) {
                 $coreSpans = &$handler->getCoreSpansArray();
                 $coreSpans[] = [
-                 "name" => "dispatch_to_server",
-                 "attributes" => [
-                     "db.system.name" => "couchbase",
-                     "network.transport" => "tcp",
-                 ],
-                 "start_timestamp" => 177272033896299000,
-                 "end_timestamp" => 177272034132668000,
+                    "dispatch_to_server",
+                    -1,
+                    177272033896299000,
+                    177272034132668000,
+                    [
+                        "db.system.name" => "couchbase",
+                        "network.transport" => "tcp",
+                    ],
                 ];
             }
         );
@@ -58,4 +59,33 @@ class ObservabilityContextTest extends Helpers\CouchbaseObservabilityTestCase
         $this->assertEquals(177272033896299000, $dispatchSpans[0]->getStartTimestampNanoseconds());
         $this->assertEquals(177272034132668000, $dispatchSpans[0]->getEndTimestampNanoseconds());
     }
+
+    public function testCanCreateNestedSpansFromFlatCoreSpanData()
+    {
+        $observabilityCtx = new ObservabilityContext(null, $this->tracer(), $this->meter());
+
+        $observabilityCtx->recordOperation(
+            "testOp",
+            $this->parentSpan(),
+            function (ObservabilityHandler $handler) {
+                $coreSpans = &$handler->getCoreSpansArray();
+                $coreSpans[] = ["dispatch_to_server", -1, 100, 400, []];
+                $coreSpans[] = ["encoding", 0, 150, 200, ["db.operation.name" => "get"]];
+                $coreSpans[] = ["dispatch_to_server", -1, 500, 900, []];
+            }
+        );
+
+        $operationSpan = $this->tracer()->getSpans(null, $this->parentSpan())[0];
+        $this->assertEquals(1, $operationSpan->getTags()["couchbase.retries"]);
+
+        $dispatchSpans = $this->tracer()->getSpans(null, $operationSpan);
+        $this->assertCount(2, $dispatchSpans);
+        $this->assertEquals(500, $dispatchSpans[1]->getStartTimestampNanoseconds());
+
+        $encodingSpans = $this->tracer()->getSpans(null, $dispatchSpans[0]);
+        $this->assertCount(1, $encodingSpans);
+        $this->assertEquals("encoding", $encodingSpans[0]->getName());
+        $this->assertEquals("get", $encodingSpans[0]->getTags()["db.operation.name"]);
+        $this->assertEquals(200, $encodingSpans[0]->getEndTimestampNanoseconds());
+    }
 }
@@ -20,6 +20,7 @@ declare(strict_types=1);
 
 include_once __DIR__ . "/Helpers/CouchbaseObservabilityTestCase.php";
 
+use Couchbase\ClusterOptions;
 use Couchbase\GetOptions;
 use Couchbase\UpsertOptions;
 use Couchbase\InsertOptions;
@@ -39,6 +40,8 @@ use Couchbase\GetAllReplicasOptions;
 use Couchbase\GetAnyReplicaOptions;
 use Couchbase\LookupInAllReplicasOptions;
 use Couchbase\LookupInAnyReplicaOptions;
+use Couchbase\Observability\ObservabilityConstants;
+use Helpers\Metrics\CountingLoggingMeter;
 use Helpers\Tracing\ParentSpanRequirement;
 use Helpers\Tracing\TestSpan;
 
@@ -99,6 +102,58 @@ class ObservabilityKeyValueOperationsTest extends Helpers\CouchbaseObservability
         $this->assertKvOperationMetrics(1, "get");
     }
 
+    public function testGetSpansOfFastOperationAreDroppedBySampling()
+    {
+        $options = new ClusterOptions();
+        $options->coreSpansSamplingThreshold(60_000);
+        $collection = $this->connectCluster($options)->bucket(self::env()->bucketName())->defaultCollection();
+
+        $collection->get(self::EXISTING_DOC_ID, GetOptions::build()->parentSpan($this->parentSpan()));
+        $getSpan = $this->tracer()->getSpans(null, $this->parentSpan())[0];
+        $this->assertEquals("get", $getSpan->getName());
+        $this->assertEmpty($this->tracer()->getSpans("dispatch_to_server", $getSpan));
+        $this->assertArrayNotHasKey("couchbase.retries", $getSpan->getTags());
+
+        $this->tracer()->reset();
+        $this->wrapException(
+            function () use ($collection) {
+                $collection->get("non-existing-id", GetOptions::build()->parentSpan($this->parentSpan()));
+            },
+            Couchbase\Exception\DocumentNotFoundException::class
+        );
+        $getSpan = $this->tracer()->getSpans(null, $this->parentSpan())[0];
+        $this->assertHasDispatchSpans($getSpan);
+    }
+
+    public function testGetWithLoggingMeterIsRecordedOnce()
+    {
+        $meter = new CountingLoggingMeter();
+        $options = new ClusterOptions();
+        $options->meter($meter);
+        $collection = $this->connectCluster($options)->bucket(self::env()->bucketName())->defaultCollection();
+
+        $collection->get(self::EXISTING_DOC_ID);
+
+        /* the extension records the duration into the meter of the core, so PHP must not record it again */
+        $function = COUCHBASE_EXTENSION_NAMESPACE . '\\coreMeteredOperations';
+        $this->assertArrayHasKey(ObservabilityConstants::OP_GET, $function());
+        $this->assertEquals(0, $meter->recordedOperations());
+    }
+
+    public function testCoreMeteredOperationsUseSdkOperationNames()
+    {
+        $operations = [];
+        foreach ((new ReflectionClass(ObservabilityConstants::class))->getConstants() as $name => $value) {
+            if (str_starts_with($name, "OP_")) {
+                $operations[$value] = true;
+            }
+        }
+        $function = COUCHBASE_EXTENSION_NAMESPACE . '\\coreMeteredOperations';
+        foreach (array_keys($function()) as $operation) {
+            $this->assertArrayHasKey($operation, $operations);
+        }
+    }
+
     public function testExists()
     {
         $collection = $this->defaultCollection();
@@ -0,0 +1,51 @@
+<?php
+
+/**
+ * Copyright 2014-Present Couchbase, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+declare(strict_types=1);
+
+include_once __DIR__ . "/Helpers/CouchbaseTestCase.php";
+
+class OtlpExporterTest extends Helpers\CouchbaseTestCase
+{
+    public function testGetIsExportedToOtlpFile()
+    {
+        $this->skipIfProtostellar();
+        $endpoint = (string)ini_get("couchbase.otlp_endpoint");
+        if (!str_starts_with($endpoint, "file://")) {
+            $this->markTestSkipped("couchbase.otlp_endpoint is not configured to export into the file");
+        }
+        $path = substr($endpoint, strlen("file://"));
+        $collection = $this->defaultCollection();
+        $id = $this->uniqueId();
+        $collection->upsert($id, ["answer" => 42]);
+        $collection->get($id);
+
+        $exported = [];
+        for ($attempt = 0; $attempt < 10 && !in_array("document_get", $exported); $attempt++) {
+            sleep(1);
+            clearstatcache();
+            foreach (file($path, FILE_IGNORE_NEW_LINES) ?: [] as $line) {
+                $request = json_decode($line, true);
+                foreach ($request["resourceSpans"][0]["scopeSpans"][0]["spans"] as $span) {
+                    $exported[] = $span["name"];
+                }
+            }
+        }
+        $this->assertContains("document_get", $exported);
+    }
+}
@@ -28,6 +28,7 @@ use Couchbase\TransactionGetMultiSpec;
 use Couchbase\TransactionGetOptions;
 use Couchbase\TransactionInsertOptions;
 use Couchbase\TransactionQueryOptions;
+use Couchbase\TransactionStageSpec;
 
 include_once __DIR__ . '/Helpers/CouchbaseTestCase.php';
 
@@ -138,6 +139,53 @@ class TransactionsTest extends Helpers\CouchbaseTestCase
         );
     }
 
+    public function testStageMulti()
+    {
+        $this->skipIfUnsupported($this->version()->supportsTransactions());
+
+        $idToInsert = $this->uniqueId();
+        $idToReplace = $this->uniqueId();
+        $idToRemove = $this->uniqueId();
+
+        $cluster = $this->connectCluster();
+
+        $collection = $cluster->bucket(self::env()->bucketName())->defaultCollection();
+        $collection->insert($idToReplace, ["foo" => "bar"]);
+        $collection->insert($idToRemove, ["foo" => "bar"]);
+
+        $cluster->transactions()->run(
+            function (TransactionAttemptContext $attempt) use ($idToRemove, $idToReplace, $idToInsert, $collection) {
+                $docToReplace = $attempt->get($collection, $idToReplace);
+                $docToRemove = $attempt->get($collection, $idToRemove);
+
+                $results = $attempt->stageMulti(
+                    [
+                    TransactionStageSpec::insert($collection, $idToInsert, ["foo" => "baz"]),
+                    TransactionStageSpec::replace($docToReplace, ["foo" => "baz"]),
+                    TransactionStageSpec::remove($docToRemove),
+                    ]
+                );
+                $this->assertCount(3, $results);
+                $this->assertEquals(["foo" => "baz"], $results[0]->content());
+                $this->assertEquals(["foo" => "baz"], $results[1]->content());
+                $this->assertNull($results[2]);
+            }
+        );
+
+        $res = $collection->get($idToInsert);
+        $this->assertEquals(["foo" => "baz"], $res->content());
+
+        $res = $collection->get($idToReplace);
+        $this->assertEquals(["foo" => "baz"], $res->content());
+
+        $this->wrapException(
+            function () use ($idToRemove, $collection) {
+                $collection->get($idToRemove);
+            },
+            Couchbase\Exception\DocumentNotFoundException::class
+        );
+    }
+
     public function testGetMultiReplicasFromPreferredZone()
     {
         $this->skipIfUnsupported(
@@ -254,6 +302,40 @@ class TransactionsTest extends Helpers\CouchbaseTestCase
         $this->assertEquals(["foo" => "bag"], $res->content());
     }
 
+    public function testQueryRowsAreDecodedInBatches()
+    {
+        $this->skipIfCaves();
+        $this->skipIfUnsupported($this->version()->supportsTransactionsQueries());
+
+        $prefix = $this->uniqueId();
+        $ids = [];
+        $cluster = $this->connectCluster();
+        $collection = $cluster->bucket(self::env()->bucketName())->defaultCollection();
+        for ($i = 0; $i < 300; ++$i) {
+            $ids[] = sprintf("%s_%03d", $prefix, $i);
+            $collection->upsert($ids[$i], ["num" => $i]);
+        }
+
+        $cluster->transactions()->run(
+            function (TransactionAttemptContext $attempt) use ($ids, $collection) {
+                $collectionQualifier = "`{$collection->bucketName()}`.`{$collection->scopeName()}`.`{$collection->name()}`";
+
+                $res = $attempt->queryRows(
+                    "SELECT num FROM $collectionQualifier WHERE META().id IN \$ids ORDER BY num ASC",
+                    TransactionQueryOptions::build()->namedParameters(['ids' => $ids])
+                );
+
+                $expected = 0;
+                foreach ($res as $row) {
+                    $this->assertEquals(["num" => $expected], $row);
+                    ++$expected;
+                }
+                $this->assertEquals(300, $expected);
+                $this->assertEquals("success", $res->metaData()->status());
+            }
+        );
+    }
+
     public function testFailsWithApplicationErrors()
     {
         $this->skipIfUnsupported($this->version()->supportsTransactions());